@@ -0,0 +1,45 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "dragonbox_to_chars.h"
+#include "int_to_chars.hpp"
+
+namespace iguana::detail {
+// write value with exactly `precision` digits after the decimal point,
+// rounding half away from zero. no shortest-digit search is performed: the
+// value is scaled to an integer and printed in two halves. values whose
+// scaled form does not fit in the 53-bit mantissa (and NaN/Infinity) fall
+// back to the shortest round-trip representation. at most 32 characters are
+// written.
+template <typename T>
+IGUANA_INLINE char *to_chars_fixed(char *p, T value,
+                                   uint32_t precision) noexcept {
+  static_assert(std::is_floating_point_v<T>);
+  constexpr double max_exact = 9007199254740992.0; // 2^53
+  if (precision > 15) {
+    precision = 15;
+  }
+  const auto scale = static_cast<double>(pow10_table[precision]);
+  const double scaled = std::fabs(static_cast<double>(value)) * scale;
+  if (!(scaled < max_exact)) [[unlikely]] {
+    return jkj::dragonbox::to_chars_n(value, p);
+  }
+
+  const auto digits = static_cast<uint64_t>(std::llround(scaled));
+  if (value < 0 && digits != 0) {
+    *p++ = '-';
+  }
+  const uint64_t int_part = digits / pow10_table[precision];
+  p = to_chars(p, int_part);
+  if (precision != 0) {
+    *p++ = '.';
+    const uint64_t frac_part = digits % pow10_table[precision];
+    const uint32_t n = count_digits(frac_part);
+    std::memset(p, '0', precision - n);
+    p = write_digits(p + precision - n, frac_part, n);
+  }
+  return p;
+}
+} // namespace iguana::detail
@@ -0,0 +1,85 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "../define.h"
+
+namespace iguana::detail {
+inline constexpr char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+inline constexpr uint64_t pow10_table[20] = {1ull,
+                                             10ull,
+                                             100ull,
+                                             1000ull,
+                                             10000ull,
+                                             100000ull,
+                                             1000000ull,
+                                             10000000ull,
+                                             100000000ull,
+                                             1000000000ull,
+                                             10000000000ull,
+                                             100000000000ull,
+                                             1000000000000ull,
+                                             10000000000000ull,
+                                             100000000000000ull,
+                                             1000000000000000ull,
+                                             10000000000000000ull,
+                                             100000000000000000ull,
+                                             1000000000000000000ull,
+                                             10000000000000000000ull};
+
+// number of decimal digits of v, derived from its bit width: 1233/4096 is
+// an approximation of log10(2), corrected by a single table comparison.
+template <typename U> IGUANA_INLINE uint32_t count_digits(U v) noexcept {
+  static_assert(std::is_unsigned_v<U>);
+  const U w = v | 1u;
+  const uint32_t t = (std::bit_width(w) * 1233) >> 12;
+  return t + (w >= pow10_table[t]);
+}
+
+template <typename U>
+IGUANA_INLINE char *write_digits(char *p, U v, uint32_t n) noexcept {
+  char *out = p + n;
+  while (v >= 100) {
+    const auto r = static_cast<uint32_t>(v % 100);
+    v /= 100;
+    out -= 2;
+    std::memcpy(out, digit_pairs + r * 2, 2);
+  }
+  if (v >= 10) {
+    std::memcpy(out - 2, digit_pairs + static_cast<uint32_t>(v) * 2, 2);
+  } else {
+    *(out - 1) = static_cast<char>('0' + v);
+  }
+  return p + n;
+}
+
+// write the decimal representation of value to p and return the end of the
+// written text. the caller guarantees room for 20 characters (21 with the
+// sign of a 64-bit value), no bounds checks are performed.
+template <typename T>
+requires std::is_integral_v<T> IGUANA_INLINE char *to_chars(char *p,
+                                                            T value) noexcept {
+  using U = std::conditional_t<(sizeof(T) > 4), uint64_t, uint32_t>;
+  U v = static_cast<U>(value);
+  if constexpr (std::is_signed_v<T>) {
+    if (value < 0) {
+      *p++ = '-';
+      v = U(0) - v;
+    }
+  }
+  return write_digits(p, v, count_digits(v));
+}
+} // namespace iguana::detail
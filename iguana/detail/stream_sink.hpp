@@ -0,0 +1,122 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace iguana {
+// an output stream for to_json/to_xml that collects the output in a fixed
+// size buffer and hands it to `flush(const char *data, size_t size)` every
+// time the buffer fills up, so a document of any size is written with a
+// constant amount of memory. the remaining bytes are flushed on destruction,
+// call flush() explicitly to observe errors.
+template <typename Flush, size_t N = 4096> class stream_sink {
+public:
+  static_assert(N > 0, "buffer size must not be zero");
+
+  explicit stream_sink(Flush flush) : flush_(std::move(flush)) {}
+  stream_sink(const stream_sink &) = delete;
+  stream_sink &operator=(const stream_sink &) = delete;
+  ~stream_sink() {
+    try {
+      flush();
+    } catch (...) {
+    }
+  }
+
+  void push_back(char c) {
+    if (size_ == N) [[unlikely]] {
+      flush();
+    }
+    buf_[size_++] = c;
+  }
+
+  stream_sink &append(const char *data, size_t len) {
+    if (len > N - size_) [[unlikely]] {
+      flush();
+      if (len >= N) {
+        flush_(data, len);
+        written_ += len;
+        return *this;
+      }
+    }
+    std::memcpy(buf_ + size_, data, len);
+    size_ += len;
+    return *this;
+  }
+
+  stream_sink &append(std::string_view str) {
+    return append(str.data(), str.size());
+  }
+
+  void flush() {
+    if (size_ != 0) {
+      flush_(buf_, size_);
+      written_ += size_;
+      size_ = 0;
+    }
+  }
+
+  // total number of bytes handed to the stream so far, including the ones
+  // still buffered
+  size_t bytes_written() const { return written_ + size_; }
+
+private:
+  Flush flush_;
+  size_t size_ = 0;
+  size_t written_ = 0;
+  char buf_[N];
+};
+
+struct ostream_flush {
+  std::ostream *os;
+  void operator()(const char *data, size_t size) const {
+    if (!os->write(data, static_cast<std::streamsize>(size))) [[unlikely]] {
+      throw std::runtime_error("write to ostream failed");
+    }
+  }
+};
+
+struct fd_flush {
+  int fd;
+  void operator()(const char *data, size_t size) const {
+    while (size > 0) {
+#ifdef _WIN32
+      const auto n = ::_write(fd, data, static_cast<unsigned int>(size));
+#else
+      const auto n = ::write(fd, data, size);
+#endif
+      if (n < 0) [[unlikely]] {
+        // interrupted by a signal before anything was written
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error("write to file descriptor failed");
+      }
+      data += n;
+      size -= static_cast<size_t>(n);
+    }
+  }
+};
+
+template <size_t N = 4096, typename Flush> auto make_sink(Flush &&flush) {
+  return stream_sink<std::decay_t<Flush>, N>(std::forward<Flush>(flush));
+}
+
+template <size_t N = 4096> auto make_ostream_sink(std::ostream &os) {
+  return stream_sink<ostream_flush, N>(ostream_flush{&os});
+}
+
+template <size_t N = 4096> auto make_fd_sink(int fd) {
+  return stream_sink<fd_flush, N>(fd_flush{fd});
+}
+} // namespace iguana
@@ -4,11 +4,11 @@
 #include <memory_resource>
 #endif
 
+#include "stream_sink.hpp"
+
 namespace iguana {
 #ifdef IGUANA_ENABLE_PMR
 #if __has_include(<memory_resource>)
-inline char iguana_buf[2048];
-inline std::pmr::monotonic_buffer_resource iguana_resource(iguana_buf, 2048);
 using string_stream = std::pmr::string;
 #endif
 #else
@@ -95,4 +95,75 @@ inline std::error_code make_error_code(iguana::dom_errc err,
 
   return std::error_code((int)err, instance);
 }
+
+// xml parse error code
+enum class xml_errc {
+  ok = 0,
+  unexpected_end,
+  expected_name,
+  expected_lt,
+  expected_gt,
+  expected_eq,
+  expected_quote,
+  invalid_number,
+  invalid_bool,
+  missing_required,
+  missing_element,
+  needs_resource,
+  mismatched_tag,
+};
+
+inline const char *xml_errc_message(xml_errc err) noexcept {
+  switch (err) {
+  case xml_errc::ok:
+    return "ok";
+  case xml_errc::unexpected_end:
+    return "unexpected end of data";
+  case xml_errc::expected_name:
+    return "expected element name";
+  case xml_errc::expected_lt:
+    return "expected <";
+  case xml_errc::expected_gt:
+    return "expected >";
+  case xml_errc::expected_eq:
+    return "expected =";
+  case xml_errc::expected_quote:
+    return "expected ' or \"";
+  case xml_errc::invalid_number:
+    return "failed to parse number";
+  case xml_errc::invalid_bool:
+    return "failed to parse bool";
+  case xml_errc::missing_required:
+    return "required field not found";
+  case xml_errc::missing_element:
+    return "element not found";
+  case xml_errc::needs_resource:
+    return "decoding an entity of a const buffer needs a memory_resource";
+  case xml_errc::mismatched_tag:
+    return "end tag does not match the start tag";
+  }
+  return "(unrecognized error)";
+}
+
+class iguana_xml_category : public std::error_category {
+public:
+  virtual const char *name() const noexcept override {
+    return "iguana::xml_category";
+  }
+  virtual std::string message(int err_val) const override {
+    return xml_errc_message(static_cast<xml_errc>(err_val));
+  }
+};
+
+inline const iguana::iguana_xml_category &xml_category() {
+  static iguana::iguana_xml_category instance;
+  return instance;
+}
+
+inline std::error_code make_error_code(iguana::xml_errc err) {
+  return std::error_code((int)err, iguana::xml_category());
+}
 } // namespace iguana
+
+template <>
+struct std::is_error_code_enum<iguana::xml_errc> : std::true_type {};
@@ -0,0 +1,293 @@
+#pragma once
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "json_reader.hpp"
+
+// conversion between REFLECTION structs and jvalue without going through the
+// text form
+namespace iguana {
+namespace detail {
+// v as an lvalue, or as an rvalue when the DOM it belongs to was moved in
+template <typename J, typename U> decltype(auto) forward_dom(U &v) {
+  if constexpr (std::is_lvalue_reference_v<J>) {
+    return static_cast<const U &>(v);
+  } else {
+    return std::move(v);
+  }
+}
+
+template <typename Alt, typename J> decltype(auto) expect_dom(J &&v) {
+  auto p = v.template get_if<Alt>();
+  if (p == nullptr) [[unlikely]] {
+    if constexpr (std::is_same_v<Alt, jobject>) {
+      throw std::runtime_error("Expected object");
+    } else if constexpr (std::is_same_v<Alt, jarray>) {
+      throw std::runtime_error("Expected array");
+    } else if constexpr (std::is_same_v<Alt, std::string>) {
+      throw std::runtime_error("Expected string");
+    } else {
+      throw std::runtime_error("Expected bool");
+    }
+  }
+  return forward_dom<J>(*p);
+}
+
+template <typename T, typename J> void from_dom_value(T &value, J &&v);
+
+// a DOM number into an integral member, it must be whole and fit
+template <std::integral U, typename N> U dom_integer(N n) {
+  if constexpr (std::is_floating_point_v<N>) {
+    constexpr int digits = std::numeric_limits<U>::digits;
+    constexpr double upper = digits == 64 ? 18446744073709551616.0
+                                          : double(uint64_t(1) << digits);
+    constexpr double lower = std::is_signed_v<U> ? -upper : 0.0;
+    if (!(n >= lower && n < upper) || std::trunc(n) != n) [[unlikely]] {
+      throw std::runtime_error("Expected integer");
+    }
+  } else {
+    if (!std::in_range<U>(n)) [[unlikely]] {
+      throw std::runtime_error("Expected integer");
+    }
+  }
+  return static_cast<U>(n);
+}
+
+template <typename K> K dom_key(const std::string &key) {
+  if constexpr (str_t<K>) {
+    return K(key);
+  } else {
+    K k{};
+    auto it = key.begin();
+    auto end = key.end();
+    parse_item(k, it, end);
+    return k;
+  }
+}
+
+template <typename T, typename J> void from_dom_value(T &value, J &&v) {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::is_same_v<U, jvalue>) {
+    value = std::forward<J>(v);
+  } else if constexpr (refletable<U>) {
+    static constexpr auto frozen_map = get_iguana_struct_map<U>();
+    for (auto &member : expect_dom<jobject>(std::forward<J>(v))) {
+      std::string_view key = member.first;
+      if (!key.empty() && key[0] == '@') [[unlikely]] {
+        key = key.substr(1);
+      }
+      if constexpr (frozen_map.size() > 0) {
+        const auto &member_it = frozen_map.find(key);
+        if (member_it != frozen_map.end()) {
+          std::visit(
+              [&](auto &&member_ptr) {
+                using V = std::decay_t<decltype(member_ptr)>;
+                if constexpr (std::is_member_pointer_v<V>) {
+                  from_dom_value(value.*member_ptr,
+                                 forward_dom<J>(member.second));
+                } else {
+                  static_assert(!sizeof(V), "type not supported");
+                }
+              },
+              member_it->second);
+        } else [[unlikely]] {
+#ifdef THROW_UNKNOWN_KEY
+          throw std::runtime_error("Unknown key: " + std::string(key));
+#endif
+        }
+      }
+    }
+  } else if constexpr (optional<U>) {
+    if (v.is_null() || v.is_undefined()) {
+      value.reset();
+    } else {
+      using value_type = typename U::value_type;
+      value.emplace();
+      if constexpr (std::is_same_v<value_type, jvalue>) {
+        *value = std::forward<J>(v);
+      } else {
+        from_dom_value(*value, std::forward<J>(v));
+      }
+    }
+  } else if constexpr (bool_t<U>) {
+    value = expect_dom<bool>(v);
+  } else if constexpr (enum_type_t<U>) {
+    std::underlying_type_t<U> underlying{};
+    from_dom_value(underlying, v);
+    value = static_cast<U>(underlying);
+  } else if constexpr (char_t<U>) {
+    const auto &str = expect_dom<std::string>(v);
+    if (str.size() != 1) [[unlikely]] {
+      throw std::runtime_error("Expected a single character");
+    }
+    value = str[0];
+  } else if constexpr (std::integral<U>) {
+    if (auto i = v.template get_if<int>()) {
+      value = dom_integer<U>(*i);
+    } else if (auto d = v.template get_if<double>()) {
+      value = dom_integer<U>(*d);
+    } else [[unlikely]] {
+      throw std::runtime_error("Expected number");
+    }
+  } else if constexpr (num_t<U>) {
+    if (auto i = v.template get_if<int>()) {
+      value = static_cast<U>(*i);
+    } else if (auto d = v.template get_if<double>()) {
+      value = static_cast<U>(*d);
+    } else [[unlikely]] {
+      throw std::runtime_error("Expected number");
+    }
+  } else if constexpr (is_fixed_v<U>) {
+    from_dom_value(value.value, v);
+  } else if constexpr (str_t<U>) {
+    value = expect_dom<std::string>(std::forward<J>(v));
+  } else if constexpr (map_container<U>) {
+    using key_type = typename U::key_type;
+    value.clear();
+    for (auto &member : expect_dom<jobject>(std::forward<J>(v))) {
+      from_dom_value(value[dom_key<key_type>(member.first)],
+                     forward_dom<J>(member.second));
+    }
+  } else if constexpr (fixed_array<U>) {
+    auto &&arr = expect_dom<jarray>(std::forward<J>(v));
+    const size_t n = (std::min)(arr.size(), std::size(value));
+    for (size_t i = 0; i < n; ++i) {
+      from_dom_value(value[i], forward_dom<J>(arr[i]));
+    }
+  } else if constexpr (container<U>) {
+    auto &&arr = expect_dom<jarray>(std::forward<J>(v));
+    value.clear();
+    if constexpr (requires { value.reserve(arr.size()); }) {
+      value.reserve(arr.size());
+    }
+    for (auto &item : arr) {
+      if constexpr (requires { value.emplace_back(); }) {
+        from_dom_value(value.emplace_back(), forward_dom<J>(item));
+      } else {
+        typename U::value_type element{};
+        from_dom_value(element, forward_dom<J>(item));
+        value.insert(std::move(element));
+      }
+    }
+  } else if constexpr (tuple<U>) {
+    auto &&arr = expect_dom<jarray>(std::forward<J>(v));
+    if (arr.size() != std::tuple_size_v<U>) [[unlikely]] {
+      throw std::runtime_error("Expected array of tuple size");
+    }
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (from_dom_value(std::get<I>(value), forward_dom<J>(arr[I])), ...);
+    }
+    (std::make_index_sequence<std::tuple_size_v<U>>{});
+  } else {
+    static_assert(!sizeof(U), "type not supported by from_dom");
+  }
+}
+
+template <typename T> jvalue to_dom_value(T &&t) {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::is_same_v<U, jvalue>) {
+    return std::forward<T>(t);
+  } else if constexpr (refletable<U>) {
+    jvalue result(std::in_place_type<jobject>);
+    auto &obj = std::get<jobject>(result);
+    obj.reserve(Reflect_members<U>::value());
+    for_each(t, [&](auto member_ptr, auto i) {
+      constexpr auto name = get_name<U, decltype(i)::value>();
+      obj.try_emplace(std::string(name.data(), name.size()),
+                      to_dom_value(std::forward<T>(t).*member_ptr));
+    });
+    return result;
+  } else if constexpr (optional<U>) {
+    if (!t.has_value()) {
+      return jvalue(nullptr);
+    }
+    return to_dom_value(*std::forward<T>(t));
+  } else if constexpr (bool_t<U>) {
+    return jvalue(std::in_place_type<bool>, t);
+  } else if constexpr (enum_type_t<U>) {
+    return to_dom_value(static_cast<std::underlying_type_t<U>>(t));
+  } else if constexpr (char_t<U>) {
+    return jvalue(std::in_place_type<std::string>, 1, t);
+  } else if constexpr (std::integral<U>) {
+    if (std::in_range<int>(t)) {
+      return jvalue(std::in_place_type<int>, static_cast<int>(t));
+    }
+    return jvalue(std::in_place_type<double>, static_cast<double>(t));
+  } else if constexpr (std::floating_point<U>) {
+    return jvalue(std::in_place_type<double>, static_cast<double>(t));
+  } else if constexpr (is_fixed_v<U>) {
+    // the precision only applies when it is written by to_json
+    return jvalue(std::in_place_type<double>, static_cast<double>(t.value));
+  } else if constexpr (str_t<U>) {
+    if constexpr (std::is_same_v<U, std::string>) {
+      return jvalue(std::in_place_type<std::string>, std::forward<T>(t));
+    } else {
+      return jvalue(std::in_place_type<std::string>, std::string_view(t));
+    }
+  } else if constexpr (map_container<U>) {
+    jvalue result(std::in_place_type<jobject>);
+    auto &obj = std::get<jobject>(result);
+    obj.reserve(t.size());
+    for (auto &[key, item] : t) {
+      if constexpr (str_t<decltype(key)>) {
+        obj.try_emplace(std::string(key),
+                        to_dom_value(forward_dom<T>(item)));
+      } else {
+        obj.try_emplace(std::to_string(key),
+                        to_dom_value(forward_dom<T>(item)));
+      }
+    }
+    return result;
+  } else if constexpr (container<U> || c_array<U>) {
+    jvalue result(std::in_place_type<jarray>);
+    auto &arr = std::get<jarray>(result);
+    arr.reserve(std::size(t));
+    for (auto &item : t) {
+      arr.push_back(to_dom_value(forward_dom<T>(item)));
+    }
+    return result;
+  } else if constexpr (tuple<U>) {
+    jvalue result(std::in_place_type<jarray>);
+    auto &arr = std::get<jarray>(result);
+    arr.reserve(std::tuple_size_v<U>);
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (arr.push_back(to_dom_value(std::get<I>(std::forward<T>(t)))), ...);
+    }
+    (std::make_index_sequence<std::tuple_size_v<U>>{});
+    return result;
+  } else {
+    static_assert(!sizeof(U), "type not supported by to_dom");
+  }
+}
+} // namespace detail
+
+// fill value from a DOM, members missing from the DOM are left untouched
+template <typename T> void from_dom(T &value, const jvalue &dom) {
+  detail::from_dom_value(value, dom);
+}
+
+// same as above, strings and containers are moved out of dom
+template <typename T> void from_dom(T &value, jvalue &&dom) {
+  detail::from_dom_value(value, std::move(dom));
+}
+
+template <typename T, typename J>
+void from_dom(T &value, J &&dom, std::error_code &ec) noexcept {
+  try {
+    from_dom(value, std::forward<J>(dom));
+    ec = {};
+  } catch (std::exception &e) {
+    ec = iguana::make_error_code(e.what());
+  }
+}
+
+// build a DOM from value, an rvalue has its strings and containers moved
+template <typename T> jvalue to_dom(T &&value) {
+  return detail::to_dom_value(std::forward<T>(value));
+}
+} // namespace iguana
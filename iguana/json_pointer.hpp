@@ -0,0 +1,197 @@
+#pragma once
+#include <concepts>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "json_reader.hpp"
+
+namespace iguana {
+// an RFC 6901 JSON Pointer such as "/features/0/geometry/type", split and
+// unescaped once so it can be resolved against many documents. it resolves
+// against a jvalue, a jnode or directly against the text of a document, in
+// which case everything outside the path is skipped without building a DOM.
+class json_pointer {
+public:
+  // the empty pointer, refers to the whole document
+  json_pointer() = default;
+
+  explicit json_pointer(std::string_view path) {
+    if (path.empty()) {
+      return;
+    }
+    if (path[0] != '/') {
+      throw std::invalid_argument("json pointer must start with /");
+    }
+    path.remove_prefix(1);
+    while (true) {
+      const auto pos = path.find('/');
+      add_step(path.substr(0, pos));
+      if (pos == std::string_view::npos) {
+        break;
+      }
+      path.remove_prefix(pos + 1);
+    }
+  }
+
+  size_t size() const noexcept { return steps_.size(); }
+
+  // the unescaped reference tokens
+  std::string_view token(size_t i) const { return steps_[i].key; }
+
+  // the referenced node of a jvalue or jnode tree, or nullptr
+  template <typename Node>
+    requires std::same_as<std::remove_const_t<Node>, jvalue> ||
+             std::same_as<std::remove_const_t<Node>, jnode>
+  Node *resolve(Node &root) const {
+    const std::remove_const_t<Node> *node = &root;
+    for (const auto &step : steps_) {
+      node = node->is_array() ? node->find(step.index) : node->find(step.key);
+      if (node == nullptr) {
+        return nullptr;
+      }
+    }
+    return const_cast<Node *>(node);
+  }
+
+  // the text of the referenced value inside json, without surrounding
+  // whitespace, or nullopt if the path does not exist
+  std::optional<std::string_view> resolve(std::string_view json) const {
+    const char *it = json.data();
+    const char *end = it + json.size();
+    std::string key;
+    for (const auto &step : steps_) {
+      skip_ws(it, end);
+      if (it == end) {
+        return std::nullopt;
+      }
+      if (*it == '{') {
+        ++it;
+        if (!find_member(it, end, step.key, key)) {
+          return std::nullopt;
+        }
+      } else if (*it == '[') {
+        ++it;
+        if (!find_element(it, end, step.index)) {
+          return std::nullopt;
+        }
+      } else {
+        return std::nullopt;
+      }
+    }
+    skip_ws(it, end);
+    if (it == end) {
+      return std::nullopt;
+    }
+    const char *start = it;
+    detail::skip_object_value(it, end);
+    while (it > start && static_cast<uint8_t>(it[-1]) < 33) {
+      --it;
+    }
+    return std::string_view(start, static_cast<size_t>(it - start));
+  }
+
+private:
+  static constexpr size_t npos = size_t(-1);
+
+  struct step {
+    std::string key;
+    // the array index the token denotes, npos if it is not one
+    size_t index;
+  };
+
+  void add_step(std::string_view token) {
+    std::string key;
+    key.reserve(token.size());
+    for (size_t i = 0; i < token.size(); ++i) {
+      if (token[i] != '~') {
+        key.push_back(token[i]);
+        continue;
+      }
+      if (i + 1 == token.size() || (token[i + 1] != '0' && token[i + 1] != '1'))
+        [[unlikely]] {
+        throw std::invalid_argument("invalid escape in json pointer");
+      }
+      key.push_back(token[++i] == '0' ? '~' : '/');
+    }
+
+    size_t index = npos;
+    if (!key.empty() && key.size() < 20 && (key[0] != '0' || key.size() == 1)) {
+      index = 0;
+      for (char c : key) {
+        if (c < '0' || c > '9') {
+          index = npos;
+          break;
+        }
+        index = index * 10 + static_cast<size_t>(c - '0');
+      }
+    }
+    steps_.push_back({std::move(key), index});
+  }
+
+  // it is past the '{', on success it is left at the value of the member
+  static bool find_member(const char *&it, const char *end,
+                          std::string_view name, std::string &key) {
+    while (true) {
+      skip_ws(it, end);
+      if (it == end || *it == '}') {
+        return false;
+      }
+      if (*it != '"') [[unlikely]] {
+        throw std::runtime_error("Expected \"");
+      }
+      const char *start = it;
+      skip_string(it, end);
+      if (it - start < 2 || it[-1] != '"') [[unlikely]] {
+        throw std::runtime_error("Expected \"");
+      }
+      std::string_view raw(start + 1, static_cast<size_t>(it - start - 2));
+      bool match_key;
+      if (raw.find('\\') == std::string_view::npos) [[likely]] {
+        match_key = raw == name;
+      } else {
+        key.clear();
+        const char *first = start;
+        detail::parse_item(key, first, end);
+        match_key = key == name;
+      }
+      skip_ws(it, end);
+      match<':'>(it, end);
+      if (match_key) {
+        return true;
+      }
+      detail::skip_object_value(it, end);
+      skip_ws(it, end);
+      if (it != end && *it == ',') {
+        ++it;
+      }
+    }
+  }
+
+  // it is past the '[', on success it is left at the element
+  static bool find_element(const char *&it, const char *end, size_t index) {
+    if (index == npos) {
+      return false;
+    }
+    for (size_t i = 0; i < index; ++i) {
+      skip_ws(it, end);
+      if (it == end || *it == ']') {
+        return false;
+      }
+      detail::skip_object_value(it, end);
+      skip_ws(it, end);
+      if (it == end || *it != ',') {
+        return false;
+      }
+      ++it;
+    }
+    skip_ws(it, end);
+    return it != end && *it != ']';
+  }
+
+  std::vector<step> steps_;
+};
+} // namespace iguana
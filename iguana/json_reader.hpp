@@ -7,6 +7,9 @@
 #include <filesystem>
 #include <forward_list>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <string_view>
 #include <type_traits>
 
@@ -119,6 +122,43 @@ template <refletable T, typename It>
 void from_json(T &value, It &&it, It &&end);
 
 namespace detail {
+// resource of the from_json call in progress on this thread, nullptr if the
+// caller did not pass one
+inline thread_local std::pmr::memory_resource *current_resource = nullptr;
+
+class resource_scope {
+public:
+  explicit resource_scope(std::pmr::memory_resource *resource)
+      : prev_(current_resource) {
+    current_resource = resource;
+  }
+  resource_scope(const resource_scope &) = delete;
+  resource_scope &operator=(const resource_scope &) = delete;
+  ~resource_scope() { current_resource = prev_; }
+
+private:
+  std::pmr::memory_resource *prev_;
+};
+
+// a pmr string or container that is about to be overwritten is rebuilt empty
+// in the current resource, its elements then get the resource through
+// uses-allocator construction
+template <typename U> IGUANA_INLINE void adopt_resource(U &value) {
+  if constexpr (requires { typename U::allocator_type; }) {
+    using allocator_type = typename U::allocator_type;
+    if constexpr (std::is_same_v<allocator_type,
+                                 std::pmr::polymorphic_allocator<
+                                     typename allocator_type::value_type>>) {
+      auto resource = current_resource;
+      if (resource != nullptr &&
+          value.get_allocator().resource() != resource) [[unlikely]] {
+        std::destroy_at(&value);
+        std::construct_at(&value, allocator_type(resource));
+      }
+    }
+  }
+}
+
 template <refletable U, class It>
 IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
   from_json(value, it, end);
@@ -165,13 +205,49 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
   }
 }
 
+template <typename T, size_t Precision, class It>
+IGUANA_INLINE void parse_item(fixed_t<T, Precision> &value, It &&it,
+                              It &&end) {
+  parse_item(value.value, it, end);
+}
+
 template <enum_type_t U, class It>
 IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
   parse_item((int &)value, it, end);
 }
 
+IGUANA_INLINE void skip_object_value(auto &&it, auto &&end);
+
+// the text of the next value without surrounding whitespace
+template <class It>
+IGUANA_INLINE std::string_view parse_value_span(It &&it, It &&end) {
+  static_assert(std::contiguous_iterator<std::decay_t<It>>,
+                "raw_json and lazy need a contiguous input buffer");
+  skip_ws(it, end);
+  if (it == end) [[unlikely]]
+    throw std::runtime_error("Unexpected end of buffer");
+  const char *start = std::to_address(it);
+  skip_object_value(it, end);
+  auto n = static_cast<size_t>(std::to_address(it) - start);
+  while (n > 0 && static_cast<uint8_t>(start[n - 1]) < 33) {
+    --n;
+  }
+  return std::string_view(start, n);
+}
+
+template <class It>
+IGUANA_INLINE void parse_item(raw_json &value, It &&it, It &&end) {
+  value.str = parse_value_span(it, end);
+}
+
+template <typename T, class It>
+IGUANA_INLINE void parse_item(lazy<T> &value, It &&it, It &&end) {
+  value.set_raw(parse_value_span(it, end));
+}
+
 template <str_t U, class It>
 IGUANA_INLINE void parse_item(U &value, It &&it, It &&end, bool skip = false) {
+  adopt_resource(value);
   if (!skip) {
     skip_ws(it, end);
     match<'"'>(it, end);
@@ -324,6 +400,7 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
 
 template <sequence_container U, class It>
 IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+  adopt_resource(value);
   value.clear();
   skip_ws(it, end);
 
@@ -352,6 +429,7 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
 
 template <map_container U, class It>
 IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+  adopt_resource(value);
   using T = std::remove_reference_t<U>;
   skip_ws(it, end);
 
@@ -376,6 +454,10 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
 
     if constexpr (std::is_same_v<typename T::key_type, std::string>) {
       parse_item(value[key], it, end);
+    } else if constexpr (str_t<typename T::key_type> &&
+                         !std::is_same_v<typename T::key_type,
+                                         std::string_view>) {
+      parse_item(value[typename T::key_type(std::string_view(key))], it, end);
     } else {
       static thread_local typename T::key_type key_value{};
       parse_item(key_value, key.begin(), key.end());
@@ -507,6 +589,12 @@ IGUANA_INLINE void skip_object_value(auto &&it, auto &&end) {
     break;
   }
 }
+
+template <typename T> void parse_lazy(T &value, std::string_view str) {
+  auto it = str.begin();
+  auto end = str.end();
+  parse_item(value, it, end);
+}
 } // namespace detail
 
 template <refletable T, typename It>
@@ -618,6 +706,15 @@ IGUANA_INLINE void from_json(T &value, const View &view,
   }
 }
 
+// pmr strings and containers in value are allocated from resource, the
+// resource must outlive value
+template <typename T, json_view View>
+IGUANA_INLINE void from_json(T &value, const View &view,
+                             std::pmr::memory_resource *resource) {
+  detail::resource_scope scope(resource);
+  from_json(value, view);
+}
+
 template <typename T, json_byte Byte>
 IGUANA_INLINE void from_json(T &value, const Byte *data, size_t size) {
   std::string_view buffer(data, size);
@@ -681,10 +778,11 @@ inline void parse_object(jobject &result, It &&it, It &&end) {
     std::string key;
     detail::parse_item(key, it, end);
 
-    auto emplaced = result.try_emplace(key);
+    auto emplaced = result.try_emplace(std::move(key));
     if (!emplaced.second)
-      throw std::runtime_error("duplicated key " + key);
+      throw std::runtime_error("duplicated key " + emplaced.first->first);
 
+    skip_ws(it, end);
     match<':'>(it, end);
 
     parse(emplaced.first->second, it, end);
@@ -760,6 +858,218 @@ inline void parse(jvalue &result, It &&it, It &&end, std::error_code &ec) {
   }
 }
 
+namespace detail {
+// builds a jnode tree in the arena of a jdocument, children are collected on
+// a shared stack and copied out in one block once their parent is closed
+template <typename It> struct jnode_parser {
+  jdocument &doc;
+  std::vector<jnode> stack{};
+  std::string scratch{};
+
+  static uint32_t checked_size(size_t n) {
+    if (n > (std::numeric_limits<uint32_t>::max)()) [[unlikely]] {
+      throw std::runtime_error("json value too large");
+    }
+    return static_cast<uint32_t>(n);
+  }
+
+  jnode parse_string(It &it, It &end) {
+    scratch.clear();
+    parse_item(scratch, it, end);
+    jnode node;
+    node.type_ = jnode_type::string_t;
+    node.size_ = checked_size(scratch.size());
+    auto str = static_cast<char *>(doc.arena_.allocate(scratch.size() + 1, 1));
+    std::memcpy(str, scratch.data(), scratch.size());
+    str[scratch.size()] = '\0';
+    node.str_ = str;
+    return node;
+  }
+
+  // literals without '.', 'e' or 'E' that fit are read exactly into an
+  // int64, everything else as a double. returns the end of the number
+  static const char *parse_number(jnode &node, const char *first,
+                                  const char *last) {
+    const char *token_end = first;
+    bool integral = true;
+    while (token_end != last && is_numeric(*token_end)) {
+      if (*token_end == '.' || *token_end == 'e' || *token_end == 'E') {
+        integral = false;
+      }
+      ++token_end;
+    }
+    if (integral) {
+      int64_t i{};
+      auto [p, ec] = std::from_chars(first, token_end, i);
+      if (ec == std::errc{}) {
+        node.type_ = jnode_type::int_t;
+        node.i_ = i;
+        return p;
+      }
+      if (ec != std::errc::result_out_of_range) [[unlikely]] {
+        throw std::runtime_error("Failed to parse number");
+      }
+    }
+    double d{};
+    auto [p, ec] = fast_float::from_chars(first, token_end, d);
+    if (ec != std::errc{}) [[unlikely]] {
+      throw std::runtime_error("Failed to parse number");
+    }
+    node.type_ = jnode_type::double_t;
+    node.d_ = d;
+    return p;
+  }
+
+  static jnode parse_number(It &it, It &end) {
+    jnode node;
+    if constexpr (std::contiguous_iterator<It>) {
+      const char *first = &*it;
+      it += parse_number(node, first, first + std::distance(it, end)) - first;
+    } else {
+      char buffer[256];
+      size_t i{};
+      while (it != end && is_numeric(*it)) {
+        if (i > 254) [[unlikely]] {
+          throw std::runtime_error("Number is too long");
+        }
+        buffer[i++] = *it++;
+      }
+      if (parse_number(node, buffer, buffer + i) != buffer + i) [[unlikely]] {
+        throw std::runtime_error("Failed to parse number");
+      }
+    }
+    return node;
+  }
+
+  jnode parse_value(It &it, It &end) {
+    skip_ws(it, end);
+    if (it == end) [[unlikely]] {
+      throw std::runtime_error("Unexpected end of buffer");
+    }
+    jnode node;
+    switch (*it) {
+    case 'n':
+      match<"null">(it, end);
+      break;
+    case 'f':
+    case 't': {
+      bool b;
+      parse_item(b, it, end);
+      node.type_ = jnode_type::bool_t;
+      node.b_ = b;
+      break;
+    }
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+    case '-':
+      node = parse_number(it, end);
+      break;
+    case '"':
+      node = parse_string(it, end);
+      break;
+    case '[': {
+      ++it;
+      const size_t first = stack.size();
+      skip_ws(it, end);
+      if (it != end && *it == ']') {
+        ++it;
+      } else {
+        while (true) {
+          stack.push_back(parse_value(it, end));
+          if (it == end) [[unlikely]] {
+            throw std::runtime_error("Expected ]");
+          }
+          if (*it == ']') {
+            ++it;
+            break;
+          }
+          match<','>(it, end);
+        }
+      }
+      const size_t n = stack.size() - first;
+      node.type_ = jnode_type::array_t;
+      node.size_ = checked_size(n);
+      auto arr = static_cast<jnode *>(
+          doc.arena_.allocate(n * sizeof(jnode), alignof(jnode)));
+      std::uninitialized_copy(stack.begin() + first, stack.end(), arr);
+      node.arr_ = arr;
+      stack.resize(first);
+      break;
+    }
+    case '{': {
+      ++it;
+      const size_t first = stack.size();
+      skip_ws(it, end);
+      if (it != end && *it == '}') {
+        ++it;
+      } else {
+        while (true) {
+          skip_ws(it, end);
+          stack.push_back(parse_string(it, end));
+          skip_ws(it, end);
+          match<':'>(it, end);
+          stack.push_back(parse_value(it, end));
+          if (it == end) [[unlikely]] {
+            throw std::runtime_error("Expected }");
+          }
+          if (*it == '}') {
+            ++it;
+            break;
+          }
+          match<','>(it, end);
+        }
+      }
+      const size_t n = (stack.size() - first) / 2;
+      node.type_ = jnode_type::object_t;
+      node.size_ = checked_size(n);
+      auto obj = static_cast<jmember *>(
+          doc.arena_.allocate(n * sizeof(jmember), alignof(jmember)));
+      for (size_t i = 0; i < n; ++i) {
+        std::construct_at(obj + i, jmember{stack[first + 2 * i],
+                                           stack[first + 2 * i + 1]});
+      }
+      node.obj_ = obj;
+      stack.resize(first);
+      break;
+    }
+    default:
+      throw std::runtime_error("parse failed");
+    }
+    skip_ws(it, end);
+    return node;
+  }
+
+  void parse(It &it, It &end) {
+    doc.clear();
+    doc.root_ = parse_value(it, end);
+  }
+};
+} // namespace detail
+
+// compact read-only DOM, see jnode
+template <typename It> inline void parse(jdocument &doc, It &&it, It &&end) {
+  using iterator = std::remove_cvref_t<It>;
+  iterator first = it;
+  iterator last = end;
+  detail::jnode_parser<iterator>{doc}.parse(first, last);
+}
+
+// same as above, the nodes are allocated from resource from now on
+template <json_view View>
+inline void parse(jdocument &doc, const View &view,
+                  std::pmr::memory_resource *resource) {
+  doc.reset(resource);
+  parse(doc, std::begin(view), std::end(view));
+}
+
 template <typename T, json_view View>
 inline void parse(T &result, const View &view) {
   parse(result, std::begin(view), std::end(view));
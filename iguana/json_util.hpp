@@ -3,9 +3,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <bit>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <string_view>
+#include <type_traits>
 
 #include "define.h"
 
@@ -23,6 +27,42 @@ template <size_t N> struct string_literal {
   constexpr const std::string_view sv() const noexcept { return {value, size}; }
 };
 
+// a floating point member that to_json writes with a fixed number of
+// decimals instead of the shortest round-trip representation, e.g.
+// `iguana::fixed_t<double, 2> price;`. it is parsed like a plain number.
+template <typename T, size_t Precision> struct fixed_t {
+  static_assert(std::is_floating_point_v<T>, "must be floating point");
+  static_assert(Precision <= 15, "at most 15 decimals are supported");
+  using value_type = T;
+  static constexpr size_t precision = Precision;
+
+  T value{};
+
+  bool operator==(const fixed_t &) const = default;
+};
+
+template <typename T> constexpr inline bool is_fixed_v = false;
+template <typename T, size_t Precision>
+constexpr inline bool is_fixed_v<fixed_t<T, Precision>> = true;
+
+namespace detail {
+IGUANA_INLINE uint64_t load_chunk(const char *p) noexcept {
+  uint64_t chunk;
+  std::memcpy(&chunk, p, sizeof(chunk));
+  return chunk;
+}
+
+// the lowest set bit marks the first zero byte of chunk
+IGUANA_INLINE constexpr uint64_t has_zero_byte(uint64_t chunk) noexcept {
+  return (chunk - 0x0101010101010101) & ~chunk & 0x8080808080808080;
+}
+
+// the lowest set bit marks the first byte of chunk below 0x20
+IGUANA_INLINE constexpr uint64_t has_control_byte(uint64_t chunk) noexcept {
+  return (chunk - 0x2020202020202020) & ~chunk & 0x8080808080808080;
+}
+} // namespace detail
+
 template <char c> IGUANA_INLINE void match(auto &&it, auto &&end) {
   if (it == end || *it != c) [[unlikely]] {
     static constexpr char b[] = {c, '\0'};
@@ -6,9 +6,14 @@
 #define SERIALIZE_JSON_HPP
 #include "define.h"
 #include "detail/dragonbox_to_chars.h"
+#include "detail/fixed_to_chars.hpp"
+#include "detail/int_to_chars.hpp"
+#include "json_util.hpp"
 #include "reflection.hpp"
+#include "value.hpp"
 #include <math.h>
 #include <optional>
+#include <ranges>
 
 namespace iguana {
 
@@ -24,6 +29,11 @@ concept float_t = std::floating_point<std::decay_t<T>>;
 template <class T>
 concept arithmetic_t = std::is_arithmetic_v<std::decay_t<T>>;
 
+template <class T>
+concept float_range_t =
+    std::ranges::contiguous_range<std::remove_cvref_t<T>> &&
+    float_t<std::ranges::range_value_t<std::remove_cvref_t<T>>>;
+
 template <class T>
 concept enum_t = std::is_enum_v<std::decay_t<T>>;
 
@@ -63,50 +73,161 @@ IGUANA_INLINE void render_json_value(Stream &ss, bool b) {
 
 template <typename Stream, integral_t T>
 IGUANA_INLINE void render_json_value(Stream &ss, T value) {
-  char temp[20];
-  auto p = itoa_fwd(value, temp);
+  char temp[24];
+  auto p = detail::to_chars(temp, value);
   ss.append(temp, p - temp);
 }
 
-template <typename Stream>
-IGUANA_INLINE void render_json_value(Stream &ss, int64_t value) {
-  char temp[65];
-  auto p = xtoa(value, temp, 10, 1);
-  ss.append(temp, p - temp);
+template <typename Stream, float_t T>
+IGUANA_INLINE void render_json_value(Stream &ss, T &value) {
+  char temp[40];
+  const auto end = jkj::dragonbox::to_chars(value, temp);
+  const auto n = std::distance(temp, end);
+  ss.append(temp, n);
 }
 
-template <typename Stream>
-IGUANA_INLINE void render_json_value(Stream &ss, uint64_t value) {
-  char temp[65];
-  auto p = xtoa(value, temp, 10, 0);
-  ss.append(temp, p - temp);
+template <typename Stream, typename T, size_t Precision>
+IGUANA_INLINE void render_json_value(Stream &ss,
+                                     const fixed_t<T, Precision> &value) {
+  char temp[40];
+  const auto end = detail::to_chars_fixed(temp, value.value, Precision);
+  ss.append(temp, std::distance(temp, end));
 }
 
-#if defined __APPLE__
-template <typename Stream>
-IGUANA_INLINE void render_json_value(Stream &ss, long value) {
-  render_json_value(ss, (int64_t)value);
+// the array is formatted into a stack buffer and appended a chunk of
+// elements at a time, instead of paying a capacity check and a copy for
+// every element. with resize_and_overwrite it is formatted straight into the
+// stream's storage, grown once for the worst case without zero filling it.
+template <typename Stream, float_t T>
+IGUANA_INLINE void render_float_array(Stream &ss, const T *data, size_t n) {
+  constexpr size_t max_len =
+      std::is_same_v<T, float>
+          ? jkj::dragonbox::max_output_string_length<
+                jkj::dragonbox::ieee754_binary32>
+          : jkj::dragonbox::max_output_string_length<
+                jkj::dragonbox::ieee754_binary64>;
+  // elements [first, last) at p, each preceded by a comma but the first one
+  auto format = [data](char *p, size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      if (i != 0) {
+        *p++ = ',';
+      }
+      p = jkj::dragonbox::to_chars_n(data[i], p);
+    }
+    return p;
+  };
+  if constexpr (sizeof(T) > sizeof(double)) {
+    ss.push_back('[');
+    for (size_t i = 0; i < n; ++i) {
+      if (i != 0) {
+        ss.push_back(',');
+      }
+      render_json_value(ss, data[i]);
+    }
+    ss.push_back(']');
+  } else if constexpr (requires {
+                         ss.resize_and_overwrite(
+                             size_t{}, [](char *, size_t) { return size_t{}; });
+                       }) {
+    const auto old_size = ss.size();
+    ss.resize_and_overwrite(old_size + 2 + n * (max_len + 1),
+                            [&](char *buf, size_t) {
+                              char *p = buf + old_size;
+                              *p++ = '[';
+                              p = format(p, 0, n);
+                              *p++ = ']';
+                              return static_cast<size_t>(p - buf);
+                            });
+  } else {
+    constexpr size_t chunk = 32;
+    char buf[chunk * (max_len + 1)];
+    ss.push_back('[');
+    for (size_t i = 0; i < n; i += chunk) {
+      const char *p = format(buf, i, (std::min)(n, i + chunk));
+      ss.append(buf, static_cast<size_t>(p - buf));
+    }
+    ss.push_back(']');
+  }
+}
+
+// first character in [it, end) that has to be escaped in a JSON string, the
+// clean prefix can be copied as is
+IGUANA_INLINE const char *find_json_escape(const char *it,
+                                           const char *end) noexcept {
+  constexpr uint64_t quotes = 0x2222222222222222;
+  constexpr uint64_t escapes = 0x5c5c5c5c5c5c5c5c;
+  for (; end - it >= 8; it += 8) {
+    const auto chunk = detail::load_chunk(it);
+    const auto mask = detail::has_zero_byte(chunk ^ quotes) |
+                      detail::has_zero_byte(chunk ^ escapes) |
+                      detail::has_control_byte(chunk);
+    if (mask != 0) {
+      return it + (std::countr_zero(mask) >> 3);
+    }
+  }
+  for (; it < end; ++it) {
+    if (*it == '"' || *it == '\\' || static_cast<uint8_t>(*it) < 0x20) {
+      return it;
+    }
+  }
+  return end;
 }
 
 template <typename Stream>
-IGUANA_INLINE void render_json_value(Stream &ss, unsigned long value) {
-  render_json_value(ss, (uint64_t)value);
+IGUANA_INLINE void render_string(Stream &ss, const char *data, size_t size) {
+  const char *it = data;
+  const char *end = data + size;
+  ss.push_back('"');
+  while (true) {
+    const char *start = it;
+    it = find_json_escape(it, end);
+    ss.append(start, static_cast<size_t>(it - start));
+    if (it == end) {
+      break;
+    }
+    switch (*it) {
+    case '"':
+      ss.append("\\\"", 2);
+      break;
+    case '\\':
+      ss.append("\\\\", 2);
+      break;
+    case '\b':
+      ss.append("\\b", 2);
+      break;
+    case '\f':
+      ss.append("\\f", 2);
+      break;
+    case '\n':
+      ss.append("\\n", 2);
+      break;
+    case '\r':
+      ss.append("\\r", 2);
+      break;
+    case '\t':
+      ss.append("\\t", 2);
+      break;
+    default: {
+      constexpr char hex[] = "0123456789abcdef";
+      const auto c = static_cast<uint8_t>(*it);
+      const char u[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+      ss.append(u, 6);
+    }
+    }
+    ++it;
+  }
+  ss.push_back('"');
 }
-#endif
 
-template <typename Stream, float_t T>
-IGUANA_INLINE void render_json_value(Stream &ss, T &value) {
-  char temp[40];
-  const auto end = jkj::dragonbox::to_chars(value, temp);
-  const auto n = std::distance(temp, end);
-  ss.append(temp, n);
+template <typename Stream, typename Traits, typename Alloc>
+IGUANA_INLINE void
+render_json_value(Stream &ss, const std::basic_string<char, Traits, Alloc> &s) {
+  render_string(ss, s.data(), s.size());
 }
 
 template <typename Stream>
-IGUANA_INLINE void render_json_value(Stream &ss, const std::string &s) {
-  ss.push_back('"');
-  ss.append(s.data(), s.size());
-  ss.push_back('"');
+IGUANA_INLINE void render_json_value(Stream &ss, const raw_json &raw) {
+  ss.append(raw.str.data(), raw.str.size());
 }
 
 template <typename Stream>
@@ -121,8 +242,9 @@ IGUANA_INLINE void render_key(Stream &ss, T &t) {
   ss.push_back('"');
 }
 
-template <typename Stream>
-IGUANA_INLINE void render_key(Stream &ss, const std::string &s) {
+template <typename Stream, typename Traits, typename Alloc>
+IGUANA_INLINE void render_key(Stream &ss,
+                              const std::basic_string<char, Traits, Alloc> &s) {
   render_json_value(ss, s);
 }
 
@@ -149,11 +271,15 @@ IGUANA_INLINE void render_json_value(Stream &ss, std::optional<T> &val) {
 
 template <typename Stream, typename T>
 IGUANA_INLINE void render_array(Stream &ss, const T &v) {
-  ss.push_back('[');
-  join(ss, std::begin(v), std::end(v), ',',
-       [&ss](const auto &jsv)
-           IGUANA__INLINE_LAMBDA { render_json_value(ss, jsv); });
-  ss.push_back(']');
+  if constexpr (float_range_t<T>) {
+    render_float_array(ss, std::data(v), std::size(v));
+  } else {
+    ss.push_back('[');
+    join(ss, std::begin(v), std::end(v), ',',
+         [&ss](const auto &jsv)
+             IGUANA__INLINE_LAMBDA { render_json_value(ss, jsv); });
+    ss.push_back(']');
+  }
 }
 
 template <typename Stream, typename T, size_t N>
@@ -180,39 +306,227 @@ IGUANA_INLINE void render_json_value(Stream &ss, const T &o) {
 
 template <typename Stream, sequence_container_t T>
 IGUANA_INLINE void render_json_value(Stream &ss, const T &v) {
-  ss.push_back('[');
-  join(ss, v.cbegin(), v.cend(), ',',
-       [&ss](const auto &jsv)
-           IGUANA__INLINE_LAMBDA { render_json_value(ss, jsv); });
-  ss.push_back(']');
-}
-
-constexpr auto write_json_key = [](auto &s, auto i,
-                                   auto &t) IGUANA__INLINE_LAMBDA {
-  s.push_back('"');
-  constexpr auto name =
-      get_name<decltype(t),
-               decltype(i)::value>(); // will be replaced by string_view later
-  s.append(name.data(), name.size());
-  s.push_back('"');
-};
+  if constexpr (float_range_t<T>) {
+    render_float_array(ss, v.data(), v.size());
+  } else {
+    ss.push_back('[');
+    join(ss, v.cbegin(), v.cend(), ',',
+         [&ss](const auto &jsv)
+             IGUANA__INLINE_LAMBDA { render_json_value(ss, jsv); });
+    ss.push_back(']');
+  }
+}
+
+// recursive, so it must not be force inlined
+template <typename Stream, typename CharT>
+inline void render_json_value(Stream &ss, const basic_json_value<CharT> &v) {
+  using value_type = basic_json_value<CharT>;
+  switch (v.index()) {
+  case 0:
+  case 1:
+    ss.append("null", 4);
+    break;
+  case 2:
+    render_json_value(ss, std::get<bool>(v));
+    break;
+  case 3:
+    render_json_value(ss, std::get<double>(v));
+    break;
+  case 4:
+    render_json_value(ss, std::get<int>(v));
+    break;
+  case 5:
+    render_json_value(ss, std::get<typename value_type::string_type>(v));
+    break;
+  case 6: {
+    const auto &arr = std::get<typename value_type::array_type>(v);
+    ss.push_back('[');
+    for (auto it = arr.begin(); it != arr.end(); ++it) {
+      if (it != arr.begin()) {
+        ss.push_back(',');
+      }
+      render_json_value(ss, *it);
+    }
+    ss.push_back(']');
+    break;
+  }
+  case 7: {
+    const auto &obj = std::get<typename value_type::object_type>(v);
+    ss.push_back('{');
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+      if (it != obj.begin()) {
+        ss.push_back(',');
+      }
+      render_key(ss, it->first);
+      ss.push_back(':');
+      render_json_value(ss, it->second);
+    }
+    ss.push_back('}');
+    break;
+  }
+  }
+}
+
+template <typename Stream>
+inline void render_json_value(Stream &ss, const jnode &node) {
+  switch (node.type()) {
+  case jnode_type::null_t:
+    ss.append("null", 4);
+    break;
+  case jnode_type::bool_t:
+    render_json_value(ss, node.to_bool());
+    break;
+  case jnode_type::int_t:
+    render_json_value(ss, node.to_int());
+    break;
+  case jnode_type::double_t: {
+    const double d = node.to_double();
+    render_json_value(ss, d);
+    break;
+  }
+  case jnode_type::string_t: {
+    const auto str = node.to_string();
+    render_string(ss, str.data(), str.size());
+    break;
+  }
+  case jnode_type::array_t: {
+    ss.push_back('[');
+    bool first = true;
+    for (const auto &item : node.to_array()) {
+      if (!first) {
+        ss.push_back(',');
+      }
+      first = false;
+      render_json_value(ss, item);
+    }
+    ss.push_back(']');
+    break;
+  }
+  case jnode_type::object_t: {
+    ss.push_back('{');
+    bool first = true;
+    for (const auto &member : node.to_object()) {
+      if (!first) {
+        ss.push_back(',');
+      }
+      first = false;
+      const auto key = member.key.to_string();
+      render_string(ss, key.data(), key.size());
+      ss.push_back(':');
+      render_json_value(ss, member.value);
+    }
+    ss.push_back('}');
+    break;
+  }
+  }
+}
+
+template <typename Stream>
+IGUANA_INLINE void to_json(const jnode &node, Stream &s) {
+  render_json_value(s, node);
+}
+
+template <typename Stream>
+IGUANA_INLINE void to_json(const jdocument &doc, Stream &s) {
+  render_json_value(s, doc.root());
+}
+
+// an upper bound of the serialized size of v as long as no string needs
+// escaping, used to reserve the output once before writing a DOM
+template <typename CharT>
+inline size_t json_size_hint(const basic_json_value<CharT> &v) {
+  using value_type = basic_json_value<CharT>;
+  switch (v.index()) {
+  case 2:
+    return 5;
+  case 3:
+    return 24;
+  case 4:
+    return 11;
+  case 5:
+    return std::get<typename value_type::string_type>(v).size() + 2;
+  case 6: {
+    const auto &arr = std::get<typename value_type::array_type>(v);
+    size_t n = 2 + arr.size();
+    for (const auto &item : arr) {
+      n += json_size_hint(item);
+    }
+    return n;
+  }
+  case 7: {
+    const auto &obj = std::get<typename value_type::object_type>(v);
+    size_t n = 2 + obj.size() * 4;
+    for (const auto &[key, item] : obj) {
+      n += key.size() + json_size_hint(item);
+    }
+    return n;
+  }
+  default:
+    return 4;
+  }
+}
+
+// serialize a DOM, optionally reserving the output from a pre-walk of the
+// tree first
+template <typename Stream, typename CharT>
+IGUANA_INLINE void to_json(const basic_json_value<CharT> &v, Stream &s,
+                           bool reserve = false) {
+  if constexpr (requires { s.reserve(s.size()); }) {
+    if (reserve) {
+      s.reserve(s.size() + json_size_hint(v));
+    }
+  }
+  render_json_value(s, v);
+}
+
+template <typename Stream, typename T>
+IGUANA_INLINE void render_json_value(Stream &ss, const lazy<T> &value) {
+  if (value.is_dirty()) {
+    render_json_value(ss, value.get());
+  } else {
+    ss.append(value.raw().data(), value.raw().size());
+  }
+}
+
+// the literal written in front of the I-th member of T: `{"name":` for the
+// first member and `,"name":` for the others, so that the separator, the
+// quoted key and the colon are emitted with a single append.
+template <typename T, size_t I> constexpr auto make_json_key() {
+  constexpr auto name = get_name<T, I>();
+  std::array<char, name.size() + 4> key{};
+  key[0] = I == 0 ? '{' : ',';
+  key[1] = '"';
+  for (size_t i = 0; i < name.size(); ++i) {
+    key[i + 2] = name[i];
+  }
+  key[name.size() + 2] = '"';
+  key[name.size() + 3] = ':';
+  return key;
+}
+
+template <typename T, size_t I>
+inline constexpr auto json_key_v = make_json_key<std::decay_t<T>, I>();
 
 template <typename Stream, sequence_container_t T>
 IGUANA_INLINE void to_json(T &&v, Stream &s) {
   using U = typename std::decay_t<T>::value_type;
-  s.push_back('[');
-  const size_t size = v.size();
-  for (size_t i = 0; i < size; i++) {
-    if constexpr (is_reflection_v<U>) {
-      to_json(v[i], s);
-    } else {
-      render_json_value(s, v[i]);
+  if constexpr (float_range_t<T>) {
+    render_float_array(s, v.data(), v.size());
+  } else {
+    s.push_back('[');
+    const size_t size = v.size();
+    for (size_t i = 0; i < size; i++) {
+      if constexpr (is_reflection_v<U>) {
+        to_json(v[i], s);
+      } else {
+        render_json_value(s, v[i]);
+      }
+
+      if (i != size - 1)
+        s.push_back(',');
     }
-
-    if (i != size - 1)
-      s.push_back(',');
+    s.push_back(']');
   }
-  s.push_back(']');
 }
 
 template <typename Stream, tuple_t T>
@@ -237,27 +551,168 @@ IGUANA_INLINE void render_json_value(Stream &ss, const T &v) {
 
 template <typename Stream, refletable T>
 IGUANA_INLINE void to_json(T &&t, Stream &s) {
-  s.push_back('{');
-  for_each(std::forward<T>(t),
-           [&t, &s](const auto &v, auto i) IGUANA__INLINE_LAMBDA {
-             using M = decltype(iguana_reflect_members(std::forward<T>(t)));
-             constexpr auto Idx = decltype(i)::value;
-             constexpr auto Count = M::value();
-             static_assert(Idx < Count);
-
-             write_json_key(s, i, t);
-             s.push_back(':');
-
-             if constexpr (!is_reflection<decltype(v)>::value) {
-               render_json_value(s, t.*v);
-             } else {
-               to_json(t.*v, s);
-             }
-
-             if (Idx < Count - 1)
-               s.push_back(',');
-           });
-  s.push_back('}');
+  using M = decltype(iguana_reflect_members(std::forward<T>(t)));
+  if constexpr (M::value() == 0) {
+    s.append("{}", 2);
+  } else {
+    for_each(std::forward<T>(t),
+             [&t, &s](const auto &v, auto i) IGUANA__INLINE_LAMBDA {
+               constexpr auto Idx = decltype(i)::value;
+               static_assert(Idx < M::value());
+
+               constexpr auto &key = json_key_v<T, Idx>;
+               s.append(key.data(), key.size());
+
+               if constexpr (!is_reflection<decltype(v)>::value) {
+                 render_json_value(s, t.*v);
+               } else {
+                 to_json(t.*v, s);
+               }
+             });
+    s.push_back('}');
+  }
+}
+
+// `"name": `, the key of the I-th member of T in pretty output
+template <typename T, size_t I> constexpr auto make_pretty_json_key() {
+  constexpr auto name = get_name<T, I>();
+  std::array<char, name.size() + 4> key{};
+  key[0] = '"';
+  for (size_t i = 0; i < name.size(); ++i) {
+    key[i + 1] = name[i];
+  }
+  key[name.size() + 1] = '"';
+  key[name.size() + 2] = ':';
+  key[name.size() + 3] = ' ';
+  return key;
+}
+
+template <typename T, size_t I>
+inline constexpr auto pretty_json_key_v =
+    make_pretty_json_key<std::decay_t<T>, I>();
+
+inline constexpr size_t max_pretty_depth = 32;
+
+// ",\n" followed by the indentation of max_pretty_depth levels; a line break
+// with or without the preceding comma is a single append out of this table
+template <size_t Indent> constexpr auto make_pretty_indent() {
+  std::array<char, 2 + Indent * max_pretty_depth> indent{};
+  indent[0] = ',';
+  indent[1] = '\n';
+  for (size_t i = 2; i < indent.size(); ++i) {
+    indent[i] = ' ';
+  }
+  return indent;
+}
+
+template <size_t Indent>
+inline constexpr auto pretty_indent_v = make_pretty_indent<Indent>();
+
+template <size_t Indent, typename Stream>
+IGUANA_INLINE void render_pretty_newline(Stream &s, size_t depth,
+                                         bool comma) {
+  constexpr auto &indent = pretty_indent_v<Indent>;
+  const char *start = indent.data() + (comma ? 0 : 1);
+  if (depth <= max_pretty_depth) [[likely]] {
+    s.append(start, (comma ? 2 : 1) + depth * Indent);
+  } else {
+    s.append(start, indent.data() + indent.size() - start);
+    for (size_t i = max_pretty_depth * Indent; i < depth * Indent; ++i) {
+      s.push_back(' ');
+    }
+  }
+}
+
+template <size_t Indent, typename Stream, typename T>
+IGUANA_INLINE void render_json_pretty(Stream &s, T &&t, size_t depth) {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (refletable<U>) {
+    using M = decltype(iguana_reflect_members(std::forward<T>(t)));
+    if constexpr (M::value() == 0) {
+      s.append("{}", 2);
+    } else {
+      s.push_back('{');
+      for_each(std::forward<T>(t),
+               [&t, &s, depth](const auto &v, auto i) IGUANA__INLINE_LAMBDA {
+                 constexpr auto Idx = decltype(i)::value;
+                 render_pretty_newline<Indent>(s, depth + 1, Idx != 0);
+                 constexpr auto &key = pretty_json_key_v<U, Idx>;
+                 s.append(key.data(), key.size());
+                 render_json_pretty<Indent>(s, t.*v, depth + 1);
+               });
+      render_pretty_newline<Indent>(s, depth, false);
+      s.push_back('}');
+    }
+  } else if constexpr (is_template_instant_of<std::optional, U>::value) {
+    if (t) {
+      render_json_pretty<Indent>(s, *t, depth);
+    } else {
+      render_json_value(s, std::string("null"));
+    }
+  } else if constexpr (is_template_instant_of<lazy, U>::value) {
+    if (t.is_dirty()) {
+      render_json_pretty<Indent>(s, t.get(), depth);
+    } else {
+      s.append(t.raw().data(), t.raw().size());
+    }
+  } else if constexpr (associat_container_t<U>) {
+    if (t.empty()) {
+      s.append("{}", 2);
+      return;
+    }
+    s.push_back('{');
+    bool first = true;
+    for (const auto &[k, v] : t) {
+      render_pretty_newline<Indent>(s, depth + 1, !first);
+      first = false;
+      render_key(s, k);
+      s.append(": ", 2);
+      render_json_pretty<Indent>(s, v, depth + 1);
+    }
+    render_pretty_newline<Indent>(s, depth, false);
+    s.push_back('}');
+  } else if constexpr (tuple_t<U>) {
+    s.push_back('[');
+    for_each(t, [&s, depth](const auto &v, auto i) IGUANA__INLINE_LAMBDA {
+      render_pretty_newline<Indent>(s, depth + 1, decltype(i)::value != 0);
+      render_json_pretty<Indent>(s, v, depth + 1);
+    });
+    render_pretty_newline<Indent>(s, depth, false);
+    s.push_back(']');
+  } else if constexpr (std::ranges::range<U> &&
+                       !std::is_convertible_v<U, std::string_view>) {
+    if (std::ranges::empty(t)) {
+      s.append("[]", 2);
+      return;
+    }
+    s.push_back('[');
+    bool first = true;
+    for (const auto &v : t) {
+      render_pretty_newline<Indent>(s, depth + 1, !first);
+      first = false;
+      render_json_pretty<Indent>(s, v, depth + 1);
+    }
+    render_pretty_newline<Indent>(s, depth, false);
+    s.push_back(']');
+  } else {
+    render_json_value(s, t);
+  }
+}
+
+// indented output written in the same walk as to_json, every line break and
+// its indentation being one append of a compile-time string
+template <size_t Indent = 3, typename Stream, typename T>
+IGUANA_INLINE void to_json_pretty(T &&t, Stream &s) {
+  render_json_pretty<Indent>(s, std::forward<T>(t), 0);
+}
+
+// output string allocated from resource
+template <typename T>
+IGUANA_INLINE std::pmr::string to_json(T &&t,
+                                       std::pmr::memory_resource *resource) {
+  std::pmr::string s(resource);
+  to_json(std::forward<T>(t), s);
+  return s;
 }
 
 } // namespace iguana
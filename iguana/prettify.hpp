@@ -1,128 +1,246 @@
 #pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "define.h"
+#include "json_util.hpp"
 
 // https://github.com/stephenberry/glaze/blob/main/include/glaze/json/prettify.hpp
 
 namespace iguana {
 namespace detail {
-enum class general_state : uint32_t {
-  NORMAL,
-  ESCAPED,
-  STRING,
-  BEFORE_ASTERISK,
-  COMMENT,
-  BEFORE_FSLASH
-};
-
-inline void prettify_normal_state(const char c, auto &out, uint32_t &indent,
-                                  auto nl, general_state &state) noexcept {
+IGUANA_INLINE constexpr bool is_json_ws(char c) noexcept {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// first '"' or '\\' in [it, end), or end; eight bytes are tested at once by
+// building a bitmask of the bytes that equal either character
+IGUANA_INLINE const char *find_quote_or_escape(const char *it,
+                                               const char *end) noexcept {
+  constexpr uint64_t quotes = 0x2222222222222222;
+  constexpr uint64_t escapes = 0x5c5c5c5c5c5c5c5c;
+  for (; end - it >= 8; it += 8) {
+    const auto chunk = load_chunk(it);
+    const auto mask =
+        has_zero_byte(chunk ^ quotes) | has_zero_byte(chunk ^ escapes);
+    if (mask != 0) {
+      return it + (std::countr_zero(mask) >> 3);
+    }
+  }
+  for (; it < end; ++it) {
+    if (*it == '"' || *it == '\\') {
+      return it;
+    }
+  }
+  return end;
+}
+
+IGUANA_INLINE const char *skip_json_ws(const char *it,
+                                       const char *end) noexcept {
+  constexpr uint64_t spaces = 0x2020202020202020;
+  while (it < end) {
+    if (end - it >= 8 && load_chunk(it) == spaces) {
+      it += 8;
+    } else if (is_json_ws(*it)) {
+      ++it;
+    } else {
+      break;
+    }
+  }
+  return it;
+}
+
+// it points to the opening quote, the whole string including both quotes is
+// appended to out with a single copy
+IGUANA_INLINE const char *copy_json_string(const char *it, const char *end,
+                                           auto &out) {
+  const char *start = it++;
+  while (true) {
+    it = find_quote_or_escape(it, end);
+    if (it == end) [[unlikely]] {
+      break;
+    }
+    if (*it == '"') {
+      ++it;
+      break;
+    }
+    it += 2; // the escape and the escaped character
+    if (it > end) [[unlikely]] {
+      it = end;
+      break;
+    }
+  }
+  out.append(start, static_cast<size_t>(it - start));
+  return it;
+}
+
+// it points to the '/' starting a comment, returns the end of the comment
+IGUANA_INLINE const char *skip_json_comment(const char *it,
+                                            const char *end) noexcept {
+  if (end - it < 2) [[unlikely]] {
+    return end;
+  }
+  if (it[1] == '/') {
+    const auto nl = static_cast<const char *>(
+        std::memchr(it + 2, '\n', static_cast<size_t>(end - it - 2)));
+    return nl ? nl : end;
+  }
+  for (it += 2; it + 1 < end; ++it) {
+    if (it[0] == '*' && it[1] == '/') {
+      return it + 2;
+    }
+  }
+  return end;
+}
+
+IGUANA_INLINE constexpr bool is_json_token_end(char c) noexcept {
   switch (c) {
+  case ' ':
+  case '\n':
+  case '\r':
+  case '\t':
+  case '"':
+  case '/':
   case ',':
-    out += c;
-    nl();
-    break;
+  case ':':
   case '[':
-    out += c;
-    ++indent;
-    nl();
-    break;
   case ']':
-    --indent;
-    nl();
-    out += c;
-    break;
   case '{':
-    out += c;
-    ++indent;
-    nl();
-    break;
   case '}':
-    --indent;
-    nl();
-    out += c;
-    break;
-  case '\\':
-    out += c;
-    state = general_state::ESCAPED;
-    break;
-  case '\"':
-    out += c;
-    state = general_state::STRING;
-    break;
-  case '/':
-    out += " /";
-    state = general_state::BEFORE_ASTERISK;
-    break;
-  case ':':
-    out += ": ";
-    break;
-  case ' ':
-  case '\n':
-  case '\r':
-  case '\t':
-    break;
-  default:
-    out += c;
-    break;
+    return true;
   }
+  return false;
 }
+} // namespace detail
 
-inline void prettify_other_states(const char c, general_state &state) noexcept {
-  switch (state) {
-  case general_state::ESCAPED:
-    state = general_state::NORMAL;
-    break;
-  case general_state::STRING:
-    if (c == '"') {
-      state = general_state::NORMAL;
+/// <summary>
+/// remove all whitespace and comments outside of strings from a JSON string
+/// </summary>
+inline void minify(const auto &in, auto &out) noexcept {
+  out.reserve(out.size() + in.size());
+  const char *it = in.data();
+  const char *end = it + in.size();
+
+  using namespace detail;
+  while (it < end) {
+    switch (*it) {
+    case ' ':
+    case '\n':
+    case '\r':
+    case '\t':
+      it = skip_json_ws(it, end);
+      break;
+    case '"':
+      it = copy_json_string(it, end, out);
+      break;
+    case '/':
+      it = skip_json_comment(it, end);
+      break;
+    default: {
+      // structural characters, numbers and literals up to the next
+      // whitespace, string or comment are copied as one run
+      const char *start = it++;
+      while (it < end && !is_json_ws(*it) && *it != '"' && *it != '/') {
+        ++it;
+      }
+      out.append(start, static_cast<size_t>(it - start));
     }
-    break;
-  case general_state::BEFORE_ASTERISK:
-    state = general_state::COMMENT;
-    break;
-  case general_state::COMMENT:
-    if (c == '*') {
-      state = general_state::BEFORE_FSLASH;
     }
-    break;
-  case general_state::BEFORE_FSLASH:
-    if (c == '/') {
-      state = general_state::NORMAL;
-    } else {
-      state = general_state::COMMENT;
-    }
-    break;
-  default:
-    break;
   }
 }
-} // namespace detail
+
+/// <summary>
+/// allocating version of minify
+/// </summary>
+inline std::string minify(const auto &in) noexcept {
+  std::string out{};
+  minify(in, out);
+  return out;
+}
 
 /// <summary>
 /// pretty print a JSON string
 /// </summary>
 inline void prettify(const auto &in, auto &out, const bool tabs = false,
                      const uint32_t indent_size = 3) noexcept {
-  out.reserve(in.size());
+  out.reserve(out.size() + in.size());
+  const uint32_t width = tabs ? 1 : indent_size;
+  // "\n" followed by the indentation of the deepest level seen so far, a line
+  // break is a single append of a prefix of it
+  std::string line(1 + 16 * width, tabs ? '\t' : ' ');
+  line[0] = '\n';
   uint32_t indent{};
 
   auto nl = [&]() {
-    out += "\n";
-
-    for (uint32_t i = 0; i < indent * (tabs ? 1 : indent_size); i++) {
-      out += tabs ? "\t" : " ";
+    const size_t n = 1 + size_t(indent) * width;
+    if (n > line.size()) [[unlikely]] {
+      line.resize(n * 2, tabs ? '\t' : ' ');
     }
+    out.append(line.data(), n);
   };
 
-  using namespace detail;
-  general_state state{general_state::NORMAL};
+  const char *it = in.data();
+  const char *end = it + in.size();
 
-  for (auto c : in) {
-    if (state == general_state::NORMAL) {
-      prettify_normal_state(c, out, indent, nl, state);
-      continue;
-    } else {
-      out += c;
-      prettify_other_states(c, state);
+  using namespace detail;
+  while (it < end) {
+    const char c = *it;
+    switch (c) {
+    case ',':
+      out.push_back(c);
+      nl();
+      ++it;
+      break;
+    case '[':
+    case '{':
+      out.push_back(c);
+      ++indent;
+      nl();
+      ++it;
+      break;
+    case ']':
+    case '}':
+      if (indent > 0) {
+        --indent;
+      }
+      nl();
+      out.push_back(c);
+      ++it;
+      break;
+    case ':':
+      out.append(": ", 2);
+      ++it;
+      break;
+    case '"':
+      it = copy_json_string(it, end, out);
+      break;
+    case '/': {
+      const char *start = it;
+      it = skip_json_comment(it, end);
+      out.push_back(' ');
+      out.append(start, static_cast<size_t>(it - start));
+      if (it - start >= 2 && start[1] == '/') {
+        // a line comment runs to the end of the line, the next token must
+        // not end up inside it
+        nl();
+      }
+      break;
+    }
+    case ' ':
+    case '\n':
+    case '\r':
+    case '\t':
+      it = skip_json_ws(it, end);
+      break;
+    default: {
+      const char *start = it++;
+      while (it < end && !is_json_token_end(*it)) {
+        ++it;
+      }
+      out.append(start, static_cast<size_t>(it - start));
+    }
     }
   }
 }
@@ -136,4 +254,4 @@ inline std::string prettify(const auto &in, const bool tabs = false,
   prettify(in, out, tabs, indent_size);
   return out;
 }
-} // namespace iguana
\ No newline at end of file
+} // namespace iguana
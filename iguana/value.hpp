@@ -1,5 +1,17 @@
 #pragma once
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <string_view>
 #include <unordered_map>
 #include <utility>
@@ -10,16 +22,389 @@
 
 namespace iguana {
 
-#define GCC_COMPILER (defined(__GNUC__) && !defined(__clang__))
+// object storage of the DOM: members are kept in a vector in document order,
+// small objects are searched linearly and objects with more than
+// index_threshold members keep an open addressing hash index of positions,
+// so building an object is linear and lookups never modify the map. keys are
+// read-only through iterators, as in std::map, so the index stays valid.
+template <class Key, class T> class json_map {
+  // one member: iterators hand out the const key view while the vector moves
+  // members around through the mutable one, the same layout std::map nodes
+  // use in libc++
+  struct node {
+    union {
+      std::pair<Key, T> mut;
+      std::pair<const Key, T> val;
+    };
+
+    template <typename K, typename V>
+    node(std::piecewise_construct_t, K &&key, V &&value)
+        : mut(std::piecewise_construct, std::forward<K>(key),
+              std::forward<V>(value)) {}
+    node(const node &other) : mut(other.mut) {}
+    node(node &&other) noexcept : mut(std::move(other.mut)) {}
+    node &operator=(const node &other) {
+      mut = other.mut;
+      return *this;
+    }
+    node &operator=(node &&other) noexcept {
+      mut = std::move(other.mut);
+      return *this;
+    }
+    ~node() { mut.~pair(); }
+  };
+  using storage_type = std::vector<node>;
+
+  template <bool Const> class basic_iterator {
+    using base = std::conditional_t<Const, typename storage_type::const_iterator,
+                                    typename storage_type::iterator>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::pair<const Key, T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+    using reference =
+        std::conditional_t<Const, const value_type &, value_type &>;
+
+    basic_iterator() = default;
+    explicit basic_iterator(base it) : it_(it) {}
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    basic_iterator(const basic_iterator<false> &other) : it_(other.it_) {}
+
+    reference operator*() const { return it_->val; }
+    pointer operator->() const { return &it_->val; }
+    reference operator[](difference_type n) const { return it_[n].val; }
+
+    basic_iterator &operator++() {
+      ++it_;
+      return *this;
+    }
+    basic_iterator operator++(int) { return basic_iterator(it_++); }
+    basic_iterator &operator--() {
+      --it_;
+      return *this;
+    }
+    basic_iterator operator--(int) { return basic_iterator(it_--); }
+    basic_iterator &operator+=(difference_type n) {
+      it_ += n;
+      return *this;
+    }
+    basic_iterator &operator-=(difference_type n) {
+      it_ -= n;
+      return *this;
+    }
+    friend basic_iterator operator+(basic_iterator it, difference_type n) {
+      return it += n;
+    }
+    friend basic_iterator operator+(difference_type n, basic_iterator it) {
+      return it += n;
+    }
+    friend basic_iterator operator-(basic_iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const basic_iterator &lhs,
+                                     const basic_iterator &rhs) {
+      return lhs.it_ - rhs.it_;
+    }
+    friend bool operator==(const basic_iterator &lhs,
+                           const basic_iterator &rhs) = default;
+    friend auto operator<=>(const basic_iterator &lhs,
+                            const basic_iterator &rhs) = default;
+
+  private:
+    friend class json_map;
+    friend class basic_iterator<true>;
+    base it_{};
+  };
+
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = typename storage_type::size_type;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using key_view = std::basic_string_view<typename Key::value_type>;
+
+  static constexpr size_type index_threshold = 16;
+
+  json_map() = default;
+  json_map(std::initializer_list<value_type> list) {
+    for (auto &item : list) {
+      try_emplace(item.first, item.second);
+    }
+  }
+
+  iterator begin() noexcept { return iterator(items_.begin()); }
+  iterator end() noexcept { return iterator(items_.end()); }
+  const_iterator begin() const noexcept {
+    return const_iterator(items_.begin());
+  }
+  const_iterator end() const noexcept { return const_iterator(items_.end()); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  size_type size() const noexcept { return items_.size(); }
+  bool empty() const noexcept { return items_.empty(); }
+  void reserve(size_type n) { items_.reserve(n); }
+  void clear() noexcept {
+    items_.clear();
+    index_.clear();
+  }
+
+  iterator find(key_view key) {
+    const auto pos = lookup(key);
+    return pos == npos ? end() : begin() + pos;
+  }
+  const_iterator find(key_view key) const {
+    const auto pos = lookup(key);
+    return pos == npos ? end() : begin() + pos;
+  }
+
+  bool contains(key_view key) const { return lookup(key) != npos; }
+  size_type count(key_view key) const { return contains(key) ? 1 : 0; }
+
+  T &at(key_view key) {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("the key is unknown");
+    }
+    return it->second;
+  }
+  const T &at(key_view key) const {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("the key is unknown");
+    }
+    return it->second;
+  }
+
+  T &operator[](key_view key) { return try_emplace(key).first->second; }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K &&key, Args &&...args) {
+    const auto pos = lookup(key_view(key));
+    if (pos != npos) {
+      return {begin() + pos, false};
+    }
+    items_.emplace_back(std::piecewise_construct,
+                        std::forward_as_tuple(std::forward<K>(key)),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+    if (items_.size() * 2 > index_.size()) {
+      if (items_.size() > index_threshold) {
+        rebuild_index();
+      }
+    } else {
+      index_[free_slot(key_of(items_.size() - 1))] =
+          static_cast<uint32_t>(items_.size() - 1);
+    }
+    return {end() - 1, true};
+  }
+
+  template <typename K, typename V>
+  std::pair<iterator, bool> emplace(K &&key, V &&value) {
+    return try_emplace(std::forward<K>(key), std::forward<V>(value));
+  }
+
+  std::pair<iterator, bool> insert(value_type item) {
+    return try_emplace(item.first, std::move(item.second));
+  }
+
+  iterator erase(const_iterator it) {
+    const auto pos = static_cast<size_type>(it - cbegin());
+    if (!index_.empty()) {
+      erase_slot(pos);
+    }
+    auto next = items_.erase(it.it_);
+    if (items_.size() <= index_threshold) {
+      index_.clear();
+    }
+    return iterator(next);
+  }
+  size_type erase(key_view key) {
+    auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+  // member order does not take part in the comparison
+  friend bool operator==(const json_map &lhs, const json_map &rhs) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    for (const auto &[key, value] : lhs) {
+      auto it = rhs.find(key);
+      if (it == rhs.end() || !(it->second == value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  static constexpr size_type npos = size_type(-1);
+  static constexpr uint32_t empty_slot = uint32_t(-1);
+
+  key_view key_of(size_type pos) const { return key_view(items_[pos].mut.first); }
+
+  size_type home_slot(key_view key) const {
+    return std::hash<key_view>{}(key) & (index_.size() - 1);
+  }
+
+  size_type free_slot(key_view key) const {
+    auto slot = home_slot(key);
+    while (index_[slot] != empty_slot) {
+      slot = (slot + 1) & (index_.size() - 1);
+    }
+    return slot;
+  }
+
+  // position of key in items_ or npos
+  size_type lookup(key_view key) const {
+    if (index_.empty()) {
+      for (size_type i = 0; i < items_.size(); ++i) {
+        if (key_of(i) == key) {
+          return i;
+        }
+      }
+      return npos;
+    }
+    for (auto slot = home_slot(key);; slot = (slot + 1) & (index_.size() - 1)) {
+      const auto pos = index_[slot];
+      if (pos == empty_slot) {
+        return npos;
+      }
+      if (key_of(pos) == key) {
+        return pos;
+      }
+    }
+  }
 
-#ifdef GCC_COMPILER
-#include <map>
-template <class Key, class T, typename... Args>
-using json_map = std::map<Key, T, Args...>;
-#else
-template <class Key, class T, typename... Args>
-using json_map = std::unordered_map<Key, T, Args...>;
-#endif
+  // at most half full, so probe sequences stay short
+  void rebuild_index() {
+    index_.assign(std::bit_ceil(items_.size() * 4), empty_slot);
+    for (size_type i = 0; i < items_.size(); ++i) {
+      index_[free_slot(key_of(i))] = static_cast<uint32_t>(i);
+    }
+  }
+
+  // remove the slot of pos and shift back the entries probed past it, then
+  // renumber the members that follow pos
+  void erase_slot(size_type pos) {
+    const auto mask = index_.size() - 1;
+    auto hole = home_slot(key_of(pos));
+    while (index_[hole] != pos) {
+      hole = (hole + 1) & mask;
+    }
+    for (auto slot = (hole + 1) & mask; index_[slot] != empty_slot;
+         slot = (slot + 1) & mask) {
+      const auto home = home_slot(key_of(index_[slot]));
+      // the entry may move to the hole unless its home lies cyclically in
+      // (hole, slot]
+      if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+        index_[hole] = index_[slot];
+        hole = slot;
+      }
+    }
+    index_[hole] = empty_slot;
+    for (auto &slot : index_) {
+      if (slot != empty_slot && slot > pos) {
+        --slot;
+      }
+    }
+  }
+
+  storage_type items_;
+  // empty up to index_threshold members, then a power of two table of
+  // positions in items_ with empty_slot for free entries
+  std::vector<uint32_t> index_;
+};
+
+// a member that keeps the text of a JSON value instead of parsing it:
+// from_json stores the span of the value in the input, which must outlive
+// it, and to_json writes it back verbatim
+struct raw_json {
+  std::string_view str;
+  bool operator==(const raw_json &) const = default;
+};
+
+namespace detail {
+// defined in json_reader.hpp
+template <typename T> void parse_lazy(T &value, std::string_view str);
+} // namespace detail
+
+// a member that is parsed on first access: from_json only records the span of
+// the value in the input, which must outlive the object. to_json writes that
+// span back verbatim unless the value was accessed mutably since. the first
+// const access parses into a mutable cache without any locking, so a lazy
+// that is not parsed yet must not be read by several threads at once; call
+// get() on one of them first.
+template <typename T> class lazy {
+public:
+  using value_type = T;
+
+  lazy() = default;
+  lazy(T value) : value_(std::move(value)), dirty_(true) {}
+
+  lazy &operator=(T value) {
+    value_ = std::move(value);
+    raw_ = {};
+    parsed_ = true;
+    dirty_ = true;
+    return *this;
+  }
+
+  // not thread safe until is_parsed()
+  const T &get() const {
+    if (!parsed_) {
+      detail::parse_lazy(value_, raw_);
+      parsed_ = true;
+    }
+    return value_;
+  }
+  T &get() {
+    std::as_const(*this).get();
+    dirty_ = true;
+    return value_;
+  }
+
+  const T &operator*() const { return get(); }
+  T &operator*() { return get(); }
+  const T *operator->() const { return &get(); }
+  T *operator->() { return &get(); }
+
+  // the text the value was read from, empty if it was not read by from_json
+  std::string_view raw() const noexcept { return raw_; }
+  bool is_parsed() const noexcept { return parsed_; }
+  // true if the value may differ from raw()
+  bool is_dirty() const noexcept { return dirty_ || raw_.empty(); }
+
+  void set_raw(std::string_view raw) {
+    raw_ = raw;
+    parsed_ = false;
+    dirty_ = false;
+  }
+
+private:
+  mutable T value_{};
+  std::string_view raw_;
+  mutable bool parsed_ = true;
+  bool dirty_ = false;
+};
 
 enum dom_parse_error { ok, wrong_type };
 
@@ -63,30 +448,54 @@ struct basic_json_value
   bool is_array() const { return std::holds_alternative<array_type>(*this); }
   bool is_object() const { return std::holds_alternative<object_type>(*this); }
 
-  // if type is not match, will throw exception, if pass std::error_code, won't
-  // throw exception
-  template <typename T> T get() const {
-    try {
-      return std::get<T>(*this);
-    } catch (std::exception &e) {
-      auto it = type_map_.find(this->index());
-      if (it == type_map_.end()) {
-        throw std::invalid_argument("undefined type");
-      } else {
-        throw std::invalid_argument(it->second);
-      }
-    } catch (...) {
-      throw std::invalid_argument("unknown exception");
+  // pointer to the held T, or nullptr if another type is held
+  template <typename T> T *get_if() noexcept { return std::get_if<T>(this); }
+  template <typename T> const T *get_if() const noexcept {
+    return std::get_if<T>(this);
+  }
+
+  template <typename T> T *as() noexcept { return get_if<T>(); }
+  template <typename T> const T *as() const noexcept { return get_if<T>(); }
+
+  // member of an object or element of an array, nullptr if this is not an
+  // object/array or the key/index is missing. several keys and indexes walk
+  // down the tree: val.find("features", 0, "geometry")
+  const basic_json_value *find(std::basic_string_view<CharT> key) const {
+    auto obj = get_if<object_type>();
+    if (obj == nullptr) {
+      return nullptr;
     }
+    auto it = obj->find(key);
+    return it == obj->end() ? nullptr : &it->second;
+  }
+  template <std::integral I> const basic_json_value *find(I idx) const {
+    auto arr = get_if<array_type>();
+    if (arr == nullptr || static_cast<size_t>(idx) >= arr->size()) {
+      return nullptr;
+    }
+    return &(*arr)[idx];
+  }
+  template <typename First, typename... Rest>
+    requires(sizeof...(Rest) > 0)
+  const basic_json_value *find(First &&first, Rest &&...rest) const {
+    auto next = find(std::forward<First>(first));
+    return next == nullptr ? nullptr : next->find(std::forward<Rest>(rest)...);
+  }
+  template <typename... Path> basic_json_value *find(Path &&...path) {
+    return const_cast<basic_json_value *>(
+        std::as_const(*this).find(std::forward<Path>(path)...));
   }
 
+  // if type is not match, will throw exception, if pass std::error_code, won't
+  // throw exception
+  template <typename T> T get() const { return get_ref<T>(); }
+
   template <typename T> T get(std::error_code &ec) const {
-    try {
-      return get<T>();
-    } catch (std::exception &e) {
-      ec = iguana::make_error_code(iguana::dom_errc::wrong_type, e.what());
-      return T{};
+    if (auto p = get_if<T>()) {
+      return *p;
     }
+    ec = iguana::make_error_code(iguana::dom_errc::wrong_type, type_name());
+    return T{};
   }
 
   template <typename T> std::error_code get_to(T &v) const {
@@ -95,57 +504,69 @@ struct basic_json_value
     return ec;
   }
 
-  template <typename T> T at(const std::string &key) {
-    const auto &map = get<object_type>();
-    auto it = map.find(key);
-    if (it == map.end()) {
+  template <typename T> const T &at(const std::string &key) const {
+    auto p = find(std::basic_string_view<CharT>(key));
+    if (p == nullptr) {
+      get_ref<object_type>();
       throw std::invalid_argument("the key is unknown");
     }
-    return it->second.template get<T>();
+    return p->template get_ref<T>();
+  }
+
+  template <typename T> T &at(const std::string &key) {
+    return const_cast<T &>(std::as_const(*this).template at<T>(key));
   }
 
-  template <typename T> T at(const std::string &key, std::error_code &ec) {
-    const auto &map = get<object_type>(ec);
-    if (ec) {
+  template <typename T> T at(const std::string &key, std::error_code &ec) const {
+    const auto *map = get_if<object_type>();
+    if (map == nullptr) {
+      ec = iguana::make_error_code(iguana::dom_errc::wrong_type, type_name());
       return T{};
     }
 
-    auto it = map.find(key);
-    if (it == map.end()) {
+    auto it = map->find(key);
+    if (it == map->end()) {
       ec = std::make_error_code(std::errc::invalid_argument);
       return T{};
     }
     return it->second.template get<T>(ec);
   }
 
-  template <typename T> T at(size_t idx) {
-    const auto &arr = get<array_type>();
+  template <typename T> const T &at(size_t idx) const {
+    const auto &arr = get_ref<array_type>();
     if (idx >= arr.size()) {
       throw std::out_of_range("idx is out of range");
     }
-    return arr[idx].template get<T>();
+    return arr[idx].template get_ref<T>();
+  }
+
+  template <typename T> T &at(size_t idx) {
+    return const_cast<T &>(std::as_const(*this).template at<T>(idx));
   }
 
-  template <typename T> T at(size_t idx, std::error_code &ec) {
-    const auto &arr = get<array_type>(ec);
-    if (ec) {
+  template <typename T> T at(size_t idx, std::error_code &ec) const {
+    const auto *arr = get_if<array_type>();
+    if (arr == nullptr) {
+      ec = iguana::make_error_code(iguana::dom_errc::wrong_type, type_name());
       return T{};
     }
 
-    if (idx >= arr.size()) {
+    if (idx >= arr->size()) {
       ec = std::make_error_code(std::errc::result_out_of_range);
       return T{};
     }
 
-    return arr[idx].template get<T>(ec);
+    return (*arr)[idx].template get<T>(ec);
   }
 
-  object_type to_object() const { return get<object_type>(); }
+  object_type &to_object() { return get_ref<object_type>(); }
+  const object_type &to_object() const { return get_ref<object_type>(); }
   object_type to_object(std::error_code &ec) const {
     return get<object_type>(ec);
   }
 
-  array_type to_array() const { return get<array_type>(); }
+  array_type &to_array() { return get_ref<array_type>(); }
+  const array_type &to_array() const { return get_ref<array_type>(); }
   array_type to_array(std::error_code &ec) const { return get<array_type>(ec); }
 
   double to_double() const { return get<double>(); }
@@ -157,11 +578,30 @@ struct basic_json_value
   bool to_bool() const { return get<bool>(); }
   bool to_bool(std::error_code &ec) const { return get<bool>(ec); }
 
-  std::basic_string<CharT> to_string() const {
-    return get<std::basic_string<CharT>>();
+  const string_type &to_string() const { return get_ref<string_type>(); }
+  string_type to_string(std::error_code &ec) const {
+    return get<string_type>(ec);
   }
-  std::basic_string<CharT> to_string(std::error_code &ec) const {
-    return get<std::basic_string<CharT>>(ec);
+
+private:
+  const std::string &type_name() const {
+    auto it = type_map_.find(this->index());
+    if (it == type_map_.end()) {
+      static const std::string undefined = "undefined type";
+      return undefined;
+    }
+    return it->second;
+  }
+
+  template <typename T> const T &get_ref() const {
+    if (auto p = get_if<T>()) [[likely]] {
+      return *p;
+    }
+    throw std::invalid_argument(type_name());
+  }
+
+  template <typename T> T &get_ref() {
+    return const_cast<T &>(std::as_const(*this).template get_ref<T>());
   }
 };
 
@@ -184,4 +624,155 @@ void swap(basic_json_value<CharT> &lhs, basic_json_value<CharT> &rhs) noexcept {
   lhs.swap(rhs);
 }
 
+enum class jnode_type : uint8_t {
+  null_t,
+  bool_t,
+  int_t,
+  double_t,
+  string_t,
+  array_t,
+  object_t
+};
+
+struct jmember;
+class jdocument;
+
+namespace detail {
+template <typename It> struct jnode_parser;
+}
+
+// a read-only DOM node of 16 bytes: scalars are held inline, strings, arrays
+// and objects point into the arena of the jdocument that owns the tree, so a
+// node is only valid as long as its document.
+class jnode {
+public:
+  jnode_type type() const noexcept { return type_; }
+  bool is_null() const noexcept { return type_ == jnode_type::null_t; }
+  bool is_bool() const noexcept { return type_ == jnode_type::bool_t; }
+  bool is_int() const noexcept { return type_ == jnode_type::int_t; }
+  bool is_double() const noexcept { return type_ == jnode_type::double_t; }
+  bool is_number() const noexcept { return is_int() || is_double(); }
+  bool is_string() const noexcept { return type_ == jnode_type::string_t; }
+  bool is_array() const noexcept { return type_ == jnode_type::array_t; }
+  bool is_object() const noexcept { return type_ == jnode_type::object_t; }
+
+  // length of a string, number of elements or members, 0 otherwise
+  size_t size() const noexcept { return size_; }
+
+  // throw std::invalid_argument if the node holds another type
+  bool to_bool() const {
+    check(jnode_type::bool_t);
+    return b_;
+  }
+  int64_t to_int() const {
+    check(jnode_type::int_t);
+    return i_;
+  }
+  double to_double() const {
+    check(jnode_type::double_t);
+    return d_;
+  }
+  std::string_view to_string() const {
+    check(jnode_type::string_t);
+    return {str_, size_};
+  }
+  std::span<const jnode> to_array() const {
+    check(jnode_type::array_t);
+    return {arr_, size_};
+  }
+  std::span<const jmember> to_object() const;
+
+  // same as basic_json_value::find, nullptr if missing
+  const jnode *find(std::string_view key) const;
+  template <std::integral I> const jnode *find(I idx) const {
+    if (type_ != jnode_type::array_t || static_cast<size_t>(idx) >= size_) {
+      return nullptr;
+    }
+    return arr_ + idx;
+  }
+  template <typename First, typename... Rest>
+    requires(sizeof...(Rest) > 0)
+  const jnode *find(First &&first, Rest &&...rest) const {
+    auto next = find(std::forward<First>(first));
+    return next == nullptr ? nullptr : next->find(std::forward<Rest>(rest)...);
+  }
+
+private:
+  template <typename It> friend struct detail::jnode_parser;
+
+  void check(jnode_type type) const {
+    if (type_ != type) [[unlikely]] {
+      constexpr const char *names[] = {"null type",   "bool type",
+                                       "int type",    "double type",
+                                       "string type", "array type",
+                                       "object type"};
+      throw std::invalid_argument(names[static_cast<uint8_t>(type_)]);
+    }
+  }
+
+  union {
+    bool b_;
+    int64_t i_ = 0;
+    double d_;
+    const char *str_;
+    const jnode *arr_;
+    const jmember *obj_;
+  };
+  uint32_t size_ = 0;
+  jnode_type type_ = jnode_type::null_t;
+};
+
+static_assert(sizeof(jnode) == 16);
+
+struct jmember {
+  jnode key;
+  jnode value;
+};
+
+inline std::span<const jmember> jnode::to_object() const {
+  check(jnode_type::object_t);
+  return {obj_, size_};
+}
+
+inline const jnode *jnode::find(std::string_view key) const {
+  if (type_ != jnode_type::object_t) {
+    return nullptr;
+  }
+  for (const auto &member : std::span<const jmember>(obj_, size_)) {
+    if (std::string_view(member.key.str_, member.key.size_) == key) {
+      return &member.value;
+    }
+  }
+  return nullptr;
+}
+
+// owns the memory of a jnode tree, filled by parse(jdocument &, ...)
+class jdocument {
+public:
+  jdocument() = default;
+  explicit jdocument(std::pmr::memory_resource *upstream) : arena_(upstream) {}
+  jdocument(const jdocument &) = delete;
+  jdocument &operator=(const jdocument &) = delete;
+
+  const jnode &root() const noexcept { return root_; }
+
+  void clear() noexcept {
+    root_ = {};
+    arena_.release();
+  }
+
+  // drop the tree and take further memory from upstream
+  void reset(std::pmr::memory_resource *upstream) {
+    root_ = {};
+    std::destroy_at(&arena_);
+    std::construct_at(&arena_, upstream);
+  }
+
+private:
+  template <typename It> friend struct detail::jnode_parser;
+
+  std::pmr::monotonic_buffer_resource arena_;
+  jnode root_;
+};
+
 } // namespace iguana
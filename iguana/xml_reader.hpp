@@ -1,19 +1,95 @@
 #pragma once
+#include "error_code.h"
 #include "reflection.hpp"
 #include "type_traits.hpp"
 #include <algorithm>
+#include <array>
 #include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <exception>
 #include <functional>
+#include <istream>
+#include <memory_resource>
 #include <msstl/charconv.hpp>
 #include <optional>
 #include <rapidxml.hpp>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace iguana {
-inline std::string g_xml_read_err;
+// the message of the last failed from_xml on this thread
+inline thread_local std::string g_xml_read_err;
 template <typename T> void do_read(rapidxml::xml_node<char> *node, T &&t);
 
+// why and where a from_xml call stopped
+struct xml_error {
+  static constexpr size_t max_path = 8;
+
+  xml_errc code = xml_errc::ok;
+  // the innermost element being read, it points into the parsed buffer
+  std::string_view element;
+  // from the start of the buffer
+  size_t offset = 0;
+  // the elements being read from the root down to element, only the
+  // innermost max_path are kept. diagnostics leave it empty
+  std::array<std::string_view, max_path> path{};
+  size_t path_size = 0;
+
+  explicit operator bool() const noexcept { return code != xml_errc::ok; }
+  std::error_code error_code() const noexcept { return make_error_code(code); }
+};
+
+// thrown inside the parser, it carries no allocated message. the elements
+// it passes through on the way out are recorded innermost first
+class xml_parse_error : public std::exception {
+public:
+  xml_parse_error(xml_errc code, const char *pos,
+                  std::string_view element = {}) noexcept
+      : code_(code), pos_(pos) {
+    if (!element.empty()) {
+      push_element(element);
+    }
+  }
+
+  const char *what() const noexcept override { return xml_errc_message(code_); }
+  xml_errc code() const noexcept { return code_; }
+  const char *pos() const noexcept { return pos_; }
+  std::string_view element() const noexcept {
+    return depth_ == 0 ? std::string_view{} : path_[0];
+  }
+  // the number of elements recorded, of which the first max_path are kept
+  size_t depth() const noexcept { return depth_; }
+  std::string_view element(size_t i) const noexcept { return path_[i]; }
+  void push_element(std::string_view element) noexcept {
+    if (depth_ < path_.size()) {
+      path_[depth_] = element;
+    }
+    ++depth_;
+  }
+
+private:
+  xml_errc code_;
+  const char *pos_;
+  std::array<std::string_view, xml_error::max_path> path_;
+  size_t depth_ = 0;
+};
+
+// called for notices that do not stop parsing, such as a missing element
+// that is not required
+using xml_diagnostics = std::function<void(const xml_error &)>;
+inline thread_local xml_diagnostics g_xml_diagnostics;
+
+// install f for from_xml calls on this thread, returns the previous callback
+inline xml_diagnostics set_xml_diagnostics(xml_diagnostics f) {
+  return std::exchange(g_xml_diagnostics, std::move(f));
+}
+
 constexpr inline size_t find_underline(const char *str) {
   const char *c = str;
   for (; *c != '\0'; ++c) {
@@ -24,12 +100,15 @@ constexpr inline size_t find_underline(const char *str) {
   return c - str;
 }
 
-template <typename T> inline void missing_node_handler(std::string_view name) {
-  std::cout << name << " not found\n";
+// pos is where the parent element ends, it gives the error its offset
+template <typename T>
+inline void missing_node_handler(std::string_view name,
+                                 const char *pos = nullptr) {
   if (iguana::is_required<T>(name)) {
-    std::string err = "required filed ";
-    err.append(name).append(" not found!");
-    throw std::invalid_argument(err);
+    throw xml_parse_error(xml_errc::missing_required, pos, name);
+  }
+  if (g_xml_diagnostics) [[unlikely]] {
+    g_xml_diagnostics(xml_error{xml_errc::missing_element, name});
   }
 }
 
@@ -46,7 +125,7 @@ template <typename T> inline void parse_num(T &num, std::string_view value) {
 #else
     if (__builtin_expect(ec != std::errc{}, 0))
 #endif
-      throw std::invalid_argument("Failed to parse number");
+      throw xml_parse_error(xml_errc::invalid_number, value.data());
   } else {
     static_assert(!sizeof(T), "don't support this type");
   }
@@ -64,9 +143,11 @@ public:
       try {
         parse_num<T>(num, value_);
         return std::make_pair(true, static_cast<T>(num));
-      } catch (std::exception &e) {
+      } catch (xml_parse_error &e) {
         g_xml_read_err = e.what();
-        std::cout << "parse num failed, reason: " << e.what() << "\n";
+        if (g_xml_diagnostics) {
+          g_xml_diagnostics(xml_error{e.code()});
+        }
         return std::make_pair(false, T{});
       }
     } else {
@@ -101,43 +182,121 @@ private:
   std::string_view value_;
 };
 
+// the attributes of an element as views into the parsed buffer, in document
+// order. up to inline_capacity of them are stored without allocating and
+// lookups are linear, which beats hashing for the handful an element has
+class xml_attrs {
+public:
+  using key_type = std::string_view;
+  using mapped_type = std::string_view;
+  using value_type = std::pair<std::string_view, std::string_view>;
+  using iterator = value_type *;
+  using const_iterator = const value_type *;
+  static constexpr size_t inline_capacity = 8;
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+  iterator begin() noexcept { return data(); }
+  iterator end() noexcept { return data() + size_; }
+  const_iterator begin() const noexcept { return data(); }
+  const_iterator end() const noexcept { return data() + size_; }
+
+  // the attribute is appended, a duplicate name is kept and shadowed by the
+  // first one
+  std::pair<iterator, bool> emplace(std::string_view key,
+                                    std::string_view value) {
+    if (size_ < inline_capacity) {
+      inline_[size_] = {key, value};
+    } else {
+      if (size_ == inline_capacity) {
+        spill_.assign(inline_.begin(), inline_.end());
+      }
+      spill_.emplace_back(key, value);
+    }
+    ++size_;
+    return {end() - 1, true};
+  }
+
+  const_iterator find(std::string_view key) const noexcept {
+    return std::find_if(begin(), end(),
+                        [key](const value_type &a) { return a.first == key; });
+  }
+
+  iterator find(std::string_view key) noexcept {
+    return const_cast<iterator>(std::as_const(*this).find(key));
+  }
+
+  bool contains(std::string_view key) const noexcept {
+    return find(key) != end();
+  }
+
+  size_t count(std::string_view key) const noexcept { return contains(key); }
+
+  // the value of key, an empty view when there is no such attribute
+  std::string_view operator[](std::string_view key) const noexcept {
+    auto it = find(key);
+    return it == end() ? std::string_view{} : it->second;
+  }
+
+  std::string_view at(std::string_view key) const {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("no such attribute");
+    }
+    return it->second;
+  }
+
+  void clear() noexcept {
+    size_ = 0;
+    spill_.clear();
+  }
+
+private:
+  value_type *data() noexcept {
+    return size_ > inline_capacity ? spill_.data() : inline_.data();
+  }
+  const value_type *data() const noexcept {
+    return size_ > inline_capacity ? spill_.data() : inline_.data();
+  }
+
+  std::array<value_type, inline_capacity> inline_{};
+  std::vector<value_type> spill_;
+  size_t size_ = 0;
+};
+
 template <typename T>
-inline void parse_attribute(rapidxml::xml_node<char> *node, T &t) {
+inline void emplace_attribute(T &t, std::string_view name,
+                              std::string_view value) {
   using U = std::decay_t<T>;
   static_assert(is_map_container<U>::value, "must be map container");
   using key_type = typename U::key_type;
   using value_type = typename U::mapped_type;
   static_assert(is_str_v<key_type>, " key of attribute map must be str");
-  rapidxml::xml_attribute<> *attr = node->first_attribute();
-  while (attr != nullptr) {
-    value_type value_item;
-    std::string_view value(attr->value(), attr->value_size());
-    if constexpr (is_str_v<value_type> || std::is_same_v<any_t, value_type>) {
-      value_item = value_type{value};
-    } else if constexpr (std::is_arithmetic_v<value_type> &&
-                         !std::is_same_v<bool, value_type>) {
-      parse_num<value_type>(value_item, value);
-    } else {
-      static_assert(!sizeof(value_type), "value type not supported");
-    }
-    t.emplace(key_type(attr->name(), attr->name_size()), std::move(value_item));
-    attr = attr->next_attribute();
+  value_type value_item;
+  if constexpr (is_str_v<value_type> || std::is_same_v<any_t, value_type>) {
+    value_item = value_type{value};
+  } else if constexpr (std::is_arithmetic_v<value_type> &&
+                       !std::is_same_v<bool, value_type>) {
+    parse_num<value_type>(value_item, value);
+  } else {
+    static_assert(!sizeof(value_type), "value type not supported");
   }
+  t.emplace(key_type(name), std::move(value_item));
 }
 
-inline rapidxml::xml_node<char> *
-find_cdata(const rapidxml::xml_node<char> *node) {
-  for (auto cn = node->first_node(); cn; cn = cn->next_sibling()) {
-    if (cn->type() == rapidxml::node_cdata) {
-      return cn;
-    }
+template <typename T>
+inline void parse_attribute(rapidxml::xml_node<char> *node, T &t) {
+  rapidxml::xml_attribute<> *attr = node->first_attribute();
+  while (attr != nullptr) {
+    emplace_attribute(t, std::string_view(attr->name(), attr->name_size()),
+                      std::string_view(attr->value(), attr->value_size()));
+    attr = attr->next_attribute();
   }
-  return nullptr;
 }
 
-template <typename T>
-inline void parse_item(rapidxml::xml_node<char> *node, T &t,
-                       std::string_view value) {
+// the text of an element converted to a scalar member
+template <typename T> inline void parse_value(T &t, std::string_view value) {
   using U = std::remove_reference_t<T>;
   if constexpr (std::is_same_v<char, U>) {
     if (!value.empty())
@@ -151,13 +310,25 @@ inline void parse_item(rapidxml::xml_node<char> *node, T &t,
                  value == "FALSE") {
         t = false;
       } else {
-        throw std::invalid_argument("Failed to parse bool");
+        throw xml_parse_error(xml_errc::invalid_bool, value.data());
       }
     } else {
       parse_num<U>(t, value);
     }
   } else if constexpr (is_str_v<U>) {
     t = U{value};
+  } else {
+    static_assert(!sizeof(T), "don't support this type!!");
+  }
+}
+
+template <typename T>
+inline void parse_item(rapidxml::xml_node<char> *node, T &t,
+                       std::string_view value) {
+  using U = std::remove_reference_t<T>;
+  if constexpr (std::is_same_v<char, U> || std::is_arithmetic_v<U> ||
+                is_str_v<U>) {
+    parse_value(t, value);
   } else if constexpr (is_reflection_v<U>) {
     do_read(node, t);
   } else if constexpr (is_std_optinal_v<U>) {
@@ -184,125 +355,1269 @@ inline void parse_item(rapidxml::xml_node<char> *node, T &t,
   }
 }
 
-template <typename T, typename member_type>
-inline void parse_node(rapidxml::xml_node<char> *node, member_type &&t,
-                       std::string_view name) {
-  using item_type = std::decay_t<member_type>;
-  if constexpr (std::is_same_v<cdata_t, item_type>) {
-    auto c_node = find_cdata(node);
-    if (c_node) {
-      t = cdata_t(c_node->value(), c_node->value_size());
-    }
-  } else if constexpr (
-      is_std_optinal_v<item_type>) { // std::optional<std::vector<some_object>>
-    using op_value_type = typename item_type::value_type;
-    if constexpr ((!is_str_v<op_value_type> &&
-                   is_container<op_value_type>::value) ||
-                  std::is_same_v<cdata_t, op_value_type>) {
-      op_value_type op_val;
-      parse_node<T>(node, op_val, name);
-      t = std::move(op_val);
+namespace detail {
+inline bool is_xml_ws(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline void skip_xml_ws(char *&it, char *end) {
+  while (it < end && is_xml_ws(*it)) {
+    ++it;
+  }
+}
+
+inline char *find_xml_char(char *it, char *end, char c) {
+  return static_cast<char *>(
+      std::memchr(it, c, static_cast<size_t>(end - it)));
+}
+
+inline char *find_xml_str(char *it, char *end, std::string_view str) {
+  auto pos = std::string_view(it, static_cast<size_t>(end - it)).find(str);
+  if (pos == std::string_view::npos) {
+    throw xml_parse_error(xml_errc::unexpected_end, end);
+  }
+  return it + pos;
+}
+
+inline char *encode_utf8(char *out, uint32_t code) {
+  if (code < 0x80) {
+    *out++ = static_cast<char>(code);
+  } else if (code < 0x800) {
+    *out++ = static_cast<char>(0xC0 | (code >> 6));
+    *out++ = static_cast<char>(0x80 | (code & 0x3F));
+  } else if (code < 0x10000) {
+    *out++ = static_cast<char>(0xE0 | (code >> 12));
+    *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (code & 0x3F));
+  } else {
+    *out++ = static_cast<char>(0xF0 | (code >> 18));
+    *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (code & 0x3F));
+  }
+  return out;
+}
+
+// the code point of a "#N" or "#xH" reference, or -1
+inline int64_t parse_char_ref(std::string_view ref) {
+  if (ref.size() < 2 || ref[0] != '#') {
+    return -1;
+  }
+  const bool hex = ref[1] == 'x' || ref[1] == 'X';
+  size_t i = hex ? 2 : 1;
+  if (i == ref.size()) {
+    return -1;
+  }
+  int64_t code = 0;
+  for (; i < ref.size(); ++i) {
+    const char c = ref[i];
+    int digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (hex && c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (hex && c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
     } else {
-      auto n = node->first_node(name.data());
-      if (n) {
-        parse_item(n, t, std::string_view(n->value(), n->value_size()));
+      return -1;
+    }
+    code = code * (hex ? 16 : 10) + digit;
+    if (code > 0x10FFFF) {
+      return -1;
+    }
+  }
+  return code;
+}
+
+// set by from_xml for a buffer that must not be written to
+constexpr int const_input = 0x10000;
+
+// the rapidxml flags from_xml accepts: nodes it has no use for are never
+// created and strings are never terminated, the others are honoured.
+// parse_no_element_values is rejected, members are filled from the values
+constexpr int supported_xml_flags =
+    ~rapidxml::parse_no_element_values;
+
+// where decoded text goes when the input is const
+inline thread_local std::pmr::memory_resource *xml_arena = nullptr;
+
+class arena_scope {
+public:
+  explicit arena_scope(std::pmr::memory_resource *resource)
+      : prev_(xml_arena) {
+    xml_arena = resource;
+  }
+  arena_scope(const arena_scope &) = delete;
+  arena_scope &operator=(const arena_scope &) = delete;
+  ~arena_scope() { xml_arena = prev_; }
+
+private:
+  std::pmr::memory_resource *prev_;
+};
+
+// the first character of [first, last) decode_entities has to rewrite, or
+// nullptr
+template <int Flags, bool Normalize>
+inline char *find_xml_rewrite(char *first, char *last) {
+  constexpr bool translate =
+      (Flags & rapidxml::parse_no_entity_translation) == 0;
+  if constexpr (!Normalize) {
+    return find_xml_char(first, last, '&');
+  } else {
+    for (char *p = first; p < last; ++p) {
+      if (translate && *p == '&') {
+        return p;
+      }
+      if (is_xml_ws(*p) &&
+          (*p != ' ' || (p + 1 < last && is_xml_ws(p[1])))) {
+        return p;
       }
     }
-  } else if constexpr (!is_str_v<item_type> && is_container<item_type>::value) {
-    using value_type = typename item_type::value_type;
-    if constexpr (std::is_same_v<cdata_t, value_type>) {
-      for (auto c = node->first_node(); c; c = c->next_sibling()) {
-        if (c->type() == rapidxml::node_cdata) {
-          t.push_back(value_type(c->value(), c->value_size()));
+    return nullptr;
+  }
+}
+
+// [first, last) with its entity references replaced, unknown references are
+// kept as they are. in element text, Text, parse_normalize_whitespace also
+// turns every run of whitespace into one space. the result is never longer
+// than the input so the text is decoded in place, or into a copy in
+// xml_arena when the input is const
+template <int Flags, bool Text = false>
+inline std::string_view decode_entities(char *first, char *last) {
+  constexpr bool translate =
+      (Flags & rapidxml::parse_no_entity_translation) == 0;
+  constexpr bool normalize =
+      Text && (Flags & rapidxml::parse_normalize_whitespace) != 0;
+  std::string_view text(first, static_cast<size_t>(last - first));
+  if constexpr (!translate && !normalize) {
+    return text;
+  }
+  char *in = find_xml_rewrite<Flags, normalize>(first, last);
+  if (in == nullptr) {
+    return text;
+  }
+  char *out;
+  if constexpr ((Flags & const_input) != 0) {
+    if (xml_arena == nullptr) {
+      throw xml_parse_error(xml_errc::needs_resource, in);
+    }
+    auto copy = static_cast<char *>(xml_arena->allocate(text.size(), 1));
+    std::memcpy(copy, first, static_cast<size_t>(in - first));
+    out = copy + (in - first);
+    first = copy;
+  } else {
+    out = in;
+  }
+  while (in < last) {
+    if constexpr (normalize) {
+      if (is_xml_ws(*in)) {
+        *out++ = ' ';
+        do {
+          ++in;
+        } while (in < last && is_xml_ws(*in));
+        continue;
+      }
+    }
+    if (!translate || *in != '&') {
+      *out++ = *in++;
+      continue;
+    }
+    char *semi = find_xml_char(in, (std::min)(last, in + 12), ';');
+    if (semi != nullptr) {
+      std::string_view ref(in + 1, static_cast<size_t>(semi - in - 1));
+      char c = 0;
+      if (ref == "lt") {
+        c = '<';
+      } else if (ref == "gt") {
+        c = '>';
+      } else if (ref == "amp") {
+        c = '&';
+      } else if (ref == "quot") {
+        c = '"';
+      } else if (ref == "apos") {
+        c = '\'';
+      }
+      if (c != 0) {
+        *out++ = c;
+        in = semi + 1;
+        continue;
+      }
+      if (auto code = parse_char_ref(ref); code >= 0) {
+        if constexpr ((Flags & rapidxml::parse_no_utf8) != 0) {
+          // as rapidxml, the code point is cut to one byte
+          *out++ = static_cast<char>(code);
+        } else {
+          out = encode_utf8(out, static_cast<uint32_t>(code));
         }
+        in = semi + 1;
+        continue;
       }
+    }
+    *out++ = *in++;
+  }
+  return std::string_view(first, static_cast<size_t>(out - first));
+}
+
+struct xml_tag {
+  std::string_view name;
+  // the attributes, between the name and the end of the start tag
+  char *attrs;
+  char *attrs_end;
+  // <name/>
+  bool empty;
+};
+
+// it is past the '<', it is left past the '>'
+inline xml_tag parse_start_tag(char *&it, char *end) {
+  char *name = it;
+  while (it < end && !is_xml_ws(*it) && *it != '>' && *it != '/') {
+    ++it;
+  }
+  if (it == name) {
+    throw xml_parse_error(xml_errc::expected_name, it);
+  }
+  xml_tag tag{std::string_view(name, static_cast<size_t>(it - name)), it, it,
+              false};
+  while (it < end) {
+    const char c = *it;
+    if (c == '"' || c == '\'') {
+      char *quote = find_xml_char(it + 1, end, c);
+      if (quote == nullptr) {
+        it = end;
+        break;
+      }
+      it = quote + 1;
+    } else if (c == '>') {
+      tag.attrs_end = it++;
+      return tag;
+    } else if (c == '/' && it + 1 < end && it[1] == '>') {
+      tag.attrs_end = it;
+      tag.empty = true;
+      it += 2;
+      return tag;
     } else {
-      auto n = node->first_node(name.data());
-      if (n) {
-        while (n) {
-          if (std::string_view(n->name(), n->name_size()) != name) {
-            break;
-          }
-          value_type item;
-          parse_item(n, item, std::string_view(n->value(), n->value_size()));
-          t.push_back(std::move(item));
-          n = n->next_sibling();
+      ++it;
+    }
+  }
+  throw xml_parse_error(xml_errc::expected_gt, it);
+}
+
+// it is at the '<' of a comment, CDATA section, doctype or processing
+// instruction, it is left past its end
+inline void skip_markup(char *&it, char *end) {
+  std::string_view rest(it, static_cast<size_t>(end - it));
+  if (rest.starts_with("<!--")) {
+    it = find_xml_str(it + 4, end, "-->") + 3;
+  } else if (rest.starts_with("<![CDATA[")) {
+    it = find_xml_str(it + 9, end, "]]>") + 3;
+  } else if (rest[1] == '?') {
+    it = find_xml_str(it + 2, end, "?>") + 2;
+  } else {
+    int depth = 0;
+    for (it += 2; it < end; ++it) {
+      if (*it == '[') {
+        ++depth;
+      } else if (*it == ']') {
+        --depth;
+      } else if (*it == '>' && depth <= 0) {
+        ++it;
+        return;
+      }
+    }
+    throw xml_parse_error(xml_errc::expected_gt, it);
+  }
+}
+
+// it is inside an element, depth levels below its parent, it is left past
+// the matching end tag. it and depth only ever move past complete markup, so
+// a scan stopped by end can go on from them once more input is appended
+inline void skip_element(char *&it, char *end, size_t &depth) {
+  while (true) {
+    char *lt = find_xml_char(it, end, '<');
+    if (lt == nullptr || lt + 1 == end) {
+      it = lt == nullptr ? end : lt;
+      throw xml_parse_error(xml_errc::unexpected_end, end);
+    }
+    it = lt;
+    char *p = lt;
+    if (p[1] == '/') {
+      char *gt = find_xml_char(p, end, '>');
+      if (gt == nullptr) {
+        throw xml_parse_error(xml_errc::expected_gt, p);
+      }
+      it = gt + 1;
+      if (--depth == 0) {
+        return;
+      }
+    } else if (p[1] == '!' || p[1] == '?') {
+      skip_markup(p, end);
+      it = p;
+    } else {
+      ++p;
+      const bool empty = parse_start_tag(p, end).empty;
+      it = p;
+      if (!empty) {
+        ++depth;
+      }
+    }
+  }
+}
+
+// it is past the start tag of an element that is not empty, it is left past
+// the matching end tag
+inline void skip_element(char *&it, char *end) {
+  size_t depth = 1;
+  skip_element(it, end, depth);
+}
+
+enum class xml_event { text, cdata, element, end };
+
+// the next child of the element being read. text and CDATA content are
+// returned in text, a child element in tag with it left past its start tag.
+// whitespace only text is skipped, other text keeps its surrounding
+// whitespace unless parse_trim_whitespace is set. with
+// parse_validate_closing_tags text is the name of an end tag
+template <int Flags>
+inline xml_event next_child(char *&it, char *end, std::string_view &text,
+                            xml_tag &tag) {
+  while (true) {
+    char *start = it;
+    skip_xml_ws(it, end);
+    if (it == end) {
+      throw xml_parse_error(xml_errc::unexpected_end, end);
+    }
+    if (*it != '<') {
+      char *lt = find_xml_char(it, end, '<');
+      if (lt == nullptr) {
+        throw xml_parse_error(xml_errc::unexpected_end, end);
+      }
+      if constexpr ((Flags & rapidxml::parse_trim_whitespace) != 0) {
+        text = decode_entities<Flags, true>(it, lt);
+        while (!text.empty() && is_xml_ws(text.back())) {
+          text.remove_suffix(1);
         }
       } else {
-        if constexpr (!is_std_optinal_v<value_type>) {
-          missing_node_handler<T>(name);
+        text = decode_entities<Flags, true>(start, lt);
+      }
+      it = lt;
+      return xml_event::text;
+    }
+    if (it + 1 == end) {
+      throw xml_parse_error(xml_errc::unexpected_end, end);
+    }
+    if (it[1] == '/') {
+      char *gt = find_xml_char(it, end, '>');
+      if (gt == nullptr) {
+        throw xml_parse_error(xml_errc::expected_gt, it);
+      }
+      if constexpr ((Flags & rapidxml::parse_validate_closing_tags) != 0) {
+        char *name = it + 2;
+        char *name_end = name;
+        while (name_end < gt && !is_xml_ws(*name_end)) {
+          ++name_end;
         }
+        text = std::string_view(name, static_cast<size_t>(name_end - name));
       }
+      it = gt + 1;
+      return xml_event::end;
+    }
+    if (it[1] == '!' &&
+        std::string_view(it, static_cast<size_t>(end - it))
+            .starts_with("<![CDATA[")) {
+      char *close = find_xml_str(it + 9, end, "]]>");
+      text = std::string_view(it + 9, static_cast<size_t>(close - it - 9));
+      it = close + 3;
+      return xml_event::cdata;
+    }
+    if (it[1] == '!' || it[1] == '?') {
+      skip_markup(it, end);
+      continue;
     }
+    ++it;
+    tag = parse_start_tag(it, end);
+    return xml_event::element;
+  }
+}
+
+// with parse_validate_closing_tags, name from next_child must close tag
+template <int Flags>
+inline void check_end_tag(const xml_tag &tag, std::string_view name) {
+  if constexpr ((Flags & rapidxml::parse_validate_closing_tags) != 0) {
+    if (name != tag.name) {
+      throw xml_parse_error(xml_errc::mismatched_tag, name.data());
+    }
+  }
+}
+
+// an element that is not read, it is left past its end tag. its text is
+// neither decoded nor normalized
+template <int Flags>
+inline void skip_child(const xml_tag &tag, char *&it, char *end) {
+  if (tag.empty) {
+    return;
+  }
+  if constexpr ((Flags & rapidxml::parse_validate_closing_tags) != 0) {
+    constexpr int walk = (Flags | rapidxml::parse_no_entity_translation) &
+                         ~rapidxml::parse_normalize_whitespace;
+    std::string_view text;
+    xml_tag child;
+    while (true) {
+      switch (next_child<walk>(it, end, text, child)) {
+      case xml_event::element:
+        skip_child<Flags>(child, it, end);
+        break;
+      case xml_event::end:
+        check_end_tag<Flags>(tag, text);
+        return;
+      default:
+        break;
+      }
+    }
+  } else {
+    skip_element(it, end);
+  }
+}
+
+// the value of an element is its first text child, it is left past the end
+// tag
+template <int Flags>
+inline std::string_view read_text(const xml_tag &tag, char *&it, char *end) {
+  std::string_view value;
+  if (tag.empty) {
+    return value;
+  }
+  bool found = false;
+  std::string_view text;
+  xml_tag child;
+  while (true) {
+    switch (next_child<Flags>(it, end, text, child)) {
+    case xml_event::text:
+      if (!found) {
+        value = text;
+        found = true;
+      }
+      break;
+    case xml_event::element:
+      skip_child<Flags>(child, it, end);
+      break;
+    case xml_event::cdata:
+      break;
+    case xml_event::end:
+      check_end_tag<Flags>(tag, text);
+      return value;
+    }
+  }
+}
+
+template <int Flags, typename T>
+inline void parse_attributes(T &t, const xml_tag &tag) {
+  char *it = tag.attrs;
+  char *end = tag.attrs_end;
+  while (true) {
+    skip_xml_ws(it, end);
+    if (it == end) {
+      return;
+    }
+    char *name = it;
+    while (it < end && *it != '=' && !is_xml_ws(*it)) {
+      ++it;
+    }
+    std::string_view name_view(name, static_cast<size_t>(it - name));
+    skip_xml_ws(it, end);
+    if (it == end || *it != '=') {
+      throw xml_parse_error(xml_errc::expected_eq, it);
+    }
+    ++it;
+    skip_xml_ws(it, end);
+    if (it == end || (*it != '"' && *it != '\'')) {
+      throw xml_parse_error(xml_errc::expected_quote, it);
+    }
+    const char quote = *it++;
+    char *value = it;
+    char *value_end = find_xml_char(value, end, quote);
+    if (value_end == nullptr) {
+      throw xml_parse_error(xml_errc::expected_quote, it);
+    }
+    it = value_end + 1;
+    emplace_attribute(t, name_view,
+                      decode_entities<Flags>(value, value_end));
+  }
+}
+
+template <typename T, size_t I>
+using member_t = std::remove_cvref_t<decltype(std::declval<T &>().*
+                                              std::get<I>(
+                                                  Reflect_members<
+                                                      T>::apply_impl()))>;
+
+template <typename U> constexpr bool is_cdata_member() {
+  if constexpr (std::is_same_v<U, cdata_t>) {
+    return true;
+  } else if constexpr (is_std_optinal_v<U> ||
+                       (!is_str_v<U> && is_container<U>::value &&
+                        !is_map_container<U>::value)) {
+    return std::is_same_v<typename U::value_type, cdata_t>;
+  } else {
+    return false;
+  }
+}
+
+// members filled from child elements, attribute maps and CDATA are not
+template <typename U> constexpr bool is_element_member() {
+  return !is_map_container<U>::value && !is_cdata_member<U>();
+}
+
+// members that take every matching child rather than the first one
+template <typename U> constexpr bool is_repeated_member() {
+  if constexpr (is_std_optinal_v<U>) {
+    return is_repeated_member<typename U::value_type>();
   } else {
-    auto n = node->first_node(name.data());
-    if (n) {
-      parse_item(n, t, std::string_view(n->value(), n->value_size()));
+    return !is_str_v<U> && is_container<U>::value;
+  }
+}
+
+// members whose absence is reported to missing_node_handler
+template <typename U> constexpr bool is_expected_member() {
+  if constexpr (is_std_optinal_v<U>) {
+    using value_type = typename U::value_type;
+    if constexpr (is_repeated_member<value_type>()) {
+      return !is_std_optinal_v<typename value_type::value_type>;
     } else {
-      if constexpr (!is_std_optinal_v<item_type>) {
-        missing_node_handler<T>(name);
+      return false;
+    }
+  } else if constexpr (is_repeated_member<U>()) {
+    return !is_std_optinal_v<typename U::value_type>;
+  } else {
+    return true;
+  }
+}
+
+// the element name of member I, the first '_' of a namespace_t member
+// becomes ':'
+template <typename T, size_t I> constexpr auto make_element_name() {
+  constexpr auto key = Reflect_members<T>::arr()[I];
+  std::array<char, key.size()> name{};
+  for (size_t i = 0; i < key.size(); ++i) {
+    name[i] = key.data()[i];
+  }
+  if constexpr (is_namespace_v<member_t<T, I>>) {
+    constexpr auto index_ul = find_underline(key.data());
+    static_assert(index_ul < key.size(),
+                  "'_' is needed in namesapce_t value name");
+    name[index_ul] = ':';
+  }
+  return name;
+}
+
+template <typename T, size_t I>
+inline constexpr auto element_name_v = make_element_name<T, I>();
+
+template <typename T> constexpr auto make_element_members() {
+  return []<size_t... I>(std::index_sequence<I...>) {
+    constexpr bool is_element[] = {false,
+                                   is_element_member<member_t<T, I>>()...};
+    std::array<size_t, (size_t(is_element[I + 1]) + ... + 0)> members{};
+    size_t n = 0;
+    for (size_t i = 0; i < sizeof...(I); ++i) {
+      if (is_element[i + 1]) {
+        members[n++] = i;
       }
     }
+    return members;
   }
+  (std::make_index_sequence<Reflect_members<T>::value()>{});
 }
 
+// the indices of the members of T filled from child elements
 template <typename T>
-inline void do_read(rapidxml::xml_node<char> *node, T &&t) {
-  static_assert(is_reflection_v<std::remove_reference_t<T>>,
-                "must be refletable object");
-  for_each(std::forward<T>(t), [&t, &node](const auto member_ptr, auto i) {
-    using member_ptr_type = std::decay_t<decltype(member_ptr)>;
-    using type_v =
-        decltype(std::declval<T>().*std::declval<decltype(member_ptr)>());
-    using item_type = std::decay_t<type_v>;
-
-    if constexpr (std::is_member_pointer_v<member_ptr_type>) {
-      using M = decltype(iguana_reflect_members(std::forward<T>(t)));
-      constexpr auto Idx = decltype(i)::value;
-      constexpr auto Count = M::value();
-      static_assert(Idx < Count);
-      constexpr auto key = M::arr()[Idx];
-      std::string_view str = key.data();
-      if constexpr (is_map_container<item_type>::value) {
-        parse_attribute(node, t.*member_ptr);
-      } else if constexpr (is_namespace_v<item_type>) {
-        constexpr auto index_ul = find_underline(key.data());
-        static_assert(index_ul < key.size(),
-                      "'_' is needed in namesapce_t value name");
-        std::string ns(key.data(), key.size());
-        ns[index_ul] = ':';
-        parse_node<T>(node, t.*member_ptr, ns);
-      } else {
-        parse_node<T>(node, t.*member_ptr, str);
+inline constexpr auto element_members_v = make_element_members<T>();
+
+// a child element whose parsing is put off, content is the text right after
+// its start tag and end is past its end tag
+struct deferred_element {
+  size_t member;
+  xml_tag tag;
+  char *content;
+  char *end;
+};
+
+template <int Flags, typename T>
+void parse_struct(T &t, const xml_tag &tag, char *&it, char *end,
+                  std::vector<deferred_element> *deferred = nullptr);
+
+template <int Flags, typename U>
+inline void read_element(U &value, const xml_tag &tag, char *&it, char *end) {
+  if constexpr (is_reflection_v<U>) {
+    parse_struct<Flags>(value, tag, it, end);
+  } else if constexpr (is_namespace_v<U>) {
+    auto ns = typename U::value_type();
+    read_element<Flags>(ns, tag, it, end);
+    value = U{std::move(ns)};
+  } else if constexpr (is_std_optinal_v<U>) {
+    using value_type = typename U::value_type;
+    if constexpr (std::is_arithmetic_v<value_type> || is_str_v<value_type>) {
+      auto text = read_text<Flags>(tag, it, end);
+      if (!text.empty()) {
+        value_type v{};
+        parse_value(v, text);
+        value = std::move(v);
+      }
+    } else {
+      if (!value) {
+        value.emplace();
+      }
+      read_element<Flags>(*value, tag, it, end);
+    }
+  } else if constexpr (is_repeated_member<U>()) {
+    read_element<Flags>(value.emplace_back(), tag, it, end);
+  } else if constexpr (is_std_pair_v<U>) {
+    parse_attributes<Flags>(value.second, tag);
+    read_element<Flags>(value.first, tag, it, end);
+  } else {
+    parse_value(value, read_text<Flags>(tag, it, end));
+  }
+}
+
+template <typename U>
+inline void read_dom_element(rapidxml::xml_node<char> *node, U &value) {
+  if constexpr (is_repeated_member<U>()) {
+    if constexpr (is_std_optinal_v<U>) {
+      if (!value) {
+        value.emplace();
       }
+      read_dom_element(node, *value);
     } else {
-      static_assert(!sizeof(member_ptr_type), "type not supported");
+      read_dom_element(node, value.emplace_back());
+    }
+  } else {
+    parse_item(node, value, std::string_view(node->value(), node->value_size()));
+  }
+}
+
+template <int Flags, typename T, size_t I>
+void read_member(T &t, const xml_tag &tag, char *&it, char *end) {
+  read_element<Flags>(t.*std::get<I>(Reflect_members<T>::apply_impl()), tag,
+                      it, end);
+}
+
+template <typename T, size_t I>
+void read_dom_member(T &t, rapidxml::xml_node<char> *node) {
+  read_dom_element(node, t.*std::get<I>(Reflect_members<T>::apply_impl()));
+}
+
+// a vector of structs, its elements can be parsed independently of each
+// other into slots sized up front
+template <typename U> constexpr bool is_deferrable_member() {
+  if constexpr (is_repeated_member<U>() && !is_std_optinal_v<U> &&
+                requires(U &u) {
+                  u.resize(size_t{});
+                  u[size_t{}];
+                }) {
+    return is_reflection_v<typename U::value_type>;
+  } else {
+    return false;
+  }
+}
+
+struct element_info {
+  std::string_view name;
+  bool repeated;
+  bool expected;
+  bool deferrable;
+};
+
+template <typename T> constexpr auto make_element_info() {
+  constexpr auto &members = element_members_v<T>;
+  return []<size_t... J>(std::index_sequence<J...>) {
+    return std::array<element_info, sizeof...(J)>{
+        element_info{std::string_view(element_name_v<T, members[J]>.data(),
+                                      element_name_v<T, members[J]>.size()),
+                     is_repeated_member<member_t<T, members[J]>>(),
+                     is_expected_member<member_t<T, members[J]>>(),
+                     is_deferrable_member<member_t<T, members[J]>>()}...};
+  }
+  (std::make_index_sequence<members.size()>{});
+}
+
+// per child element member of T, in member order
+template <typename T>
+inline constexpr auto element_info_v = make_element_info<T>();
+
+template <int Flags, typename T>
+inline constexpr auto element_readers_v =
+    []<size_t... J>(std::index_sequence<J...>) {
+  using reader = void (*)(T &, const xml_tag &, char *&, char *);
+  return std::array<reader, sizeof...(J)>{
+      &read_member<Flags, T, element_members_v<T>[J]>...};
+}
+(std::make_index_sequence<element_members_v<T>.size()>{});
+
+template <typename T>
+inline constexpr auto dom_readers_v =
+    []<size_t... J>(std::index_sequence<J...>) {
+  using reader = void (*)(T &, rapidxml::xml_node<char> *);
+  return std::array<reader, sizeof...(J)>{
+      &read_dom_member<T, element_members_v<T>[J]>...};
+}
+(std::make_index_sequence<element_members_v<T>.size()>{});
+
+// element name to its position in element_info_v
+template <typename T> constexpr auto make_element_map() {
+  constexpr auto &members = element_members_v<T>;
+  return []<size_t... J>(std::index_sequence<J...>) {
+    return frozen::unordered_map<frozen::string, size_t, sizeof...(J)>{
+        {frozen::string(element_name_v<T, members[J]>.data(),
+                        element_name_v<T, members[J]>.size()),
+         J}...};
+  }
+  (std::make_index_sequence<members.size()>{});
+}
+
+template <typename T>
+inline constexpr auto element_map_v = make_element_map<T>();
+
+// the position of name in element_info_v, or -1
+template <typename T> inline int find_element(std::string_view name) {
+  if constexpr (element_members_v<T>.size() > 0) {
+    constexpr auto &map = element_map_v<T>;
+    auto found = map.find(name);
+    if (found != map.end()) {
+      return static_cast<int>(found->second);
+    }
+  }
+  return -1;
+}
+
+// pos() is where the element ends, it is only asked for when a member is
+// missing
+template <typename T, size_t N, typename F>
+inline void check_missing(const std::array<bool, N> &seen, const F &pos) {
+  constexpr auto &info = element_info_v<T>;
+  for (size_t j = 0; j < N; ++j) {
+    if (!seen[j] && info[j].expected) {
+      missing_node_handler<T>(info[j].name, pos());
+    }
+  }
+}
+
+template <typename T>
+inline void read_cdata(T &t, std::string_view text, bool first) {
+  for_each(t, [&](auto member_ptr, auto) {
+    using U = std::remove_cvref_t<decltype(t.*member_ptr)>;
+    if constexpr (std::is_same_v<U, cdata_t> ||
+                  std::is_same_v<U, std::optional<cdata_t>>) {
+      if (first) {
+        t.*member_ptr = cdata_t(text.data(), text.size());
+      }
+    } else if constexpr (is_cdata_member<U>()) {
+      (t.*member_ptr).push_back(cdata_t(text.data(), text.size()));
+    }
+  });
+}
+
+// tag is the start tag of t, it is left past the end tag. children are
+// dispatched by name, the first match wins for members that are not
+// containers and unknown children are skipped. with deferred, children of
+// deferrable members are only located and appended to it
+template <int Flags, typename T>
+void parse_struct(T &t, const xml_tag &tag, char *&it, char *end,
+                  std::vector<deferred_element> *deferred) {
+  constexpr auto &info = element_info_v<T>;
+  constexpr auto &readers = element_readers_v<Flags, T>;
+  for_each(t, [&](auto member_ptr, auto) {
+    using U = std::remove_cvref_t<decltype(t.*member_ptr)>;
+    if constexpr (is_map_container<U>::value) {
+      parse_attributes<Flags>(t.*member_ptr, tag);
+    }
+  });
+
+  std::array<bool, info.size()> seen{};
+  // the child being read, an error in it is reported there
+  std::string_view current;
+  try {
+    if (!tag.empty) {
+      bool first_cdata = true;
+      std::string_view text;
+      xml_tag child;
+      while (true) {
+        const auto event = next_child<Flags>(it, end, text, child);
+        if (event == xml_event::end) {
+          check_end_tag<Flags>(tag, text);
+          break;
+        }
+        if (event == xml_event::cdata) {
+          read_cdata(t, text, first_cdata);
+          first_cdata = false;
+        } else if (event == xml_event::element) {
+          const int j = find_element<T>(child.name);
+          if (j >= 0 && (!seen[j] || info[j].repeated)) {
+            seen[j] = true;
+            current = child.name;
+            if (deferred != nullptr && info[j].deferrable) {
+              char *content = it;
+              if (!child.empty) {
+                skip_element(it, end);
+              }
+              deferred->push_back({static_cast<size_t>(j), child, content, it});
+            } else {
+              readers[j](t, child, it, end);
+            }
+            current = {};
+          } else {
+            skip_child<Flags>(child, it, end);
+          }
+        }
+      }
+    }
+    check_missing<T>(seen, [&] {
+      // the '<' of the end tag, or the "/>" of an empty element
+      const char *close = tag.attrs_end;
+      if (!tag.empty) {
+        close = it - 1;
+        while (*close != '<') {
+          --close;
+        }
+      }
+      return close;
+    });
+  } catch (xml_parse_error &e) {
+    // a nested struct has already recorded the child
+    if (e.depth() == 0 && !current.empty()) {
+      e.push_element(current);
+    }
+    e.push_element(tag.name);
+    throw;
+  }
+}
+
+// returns the name of the root element
+template <int Flags, typename T>
+inline std::string_view
+parse_document(T &t, char *it, char *end,
+               std::vector<deferred_element> *deferred = nullptr) {
+  static_assert((Flags & ~supported_xml_flags) == 0,
+                "parse_no_element_values is not supported by from_xml");
+  while (true) {
+    skip_xml_ws(it, end);
+    if (it == end) {
+      return {};
+    }
+    if (*it != '<') {
+      throw xml_parse_error(xml_errc::expected_lt, it);
+    }
+    if (it + 1 < end && (it[1] == '?' || it[1] == '!')) {
+      skip_markup(it, end);
+      continue;
+    }
+    ++it;
+    auto tag = parse_start_tag(it, end);
+    parse_struct<Flags>(t, tag, it, end, deferred);
+    return tag.name;
+  }
+}
+
+// clear value for the next element of a stream, containers and strings keep
+// their capacity
+template <typename U> inline void reset_value(U &value) {
+  if constexpr (is_reflection_v<U>) {
+    for_each(value,
+             [&](auto member_ptr, auto) { reset_value(value.*member_ptr); });
+  } else if constexpr (is_std_optinal_v<U>) {
+    value.reset();
+  } else if constexpr (is_container<U>::value) {
+    value.clear();
+  } else {
+    value = U();
+  }
+}
+
+// where next_streamed stopped in a cut off element, offset is from its '<'
+struct streamed_scan {
+  size_t depth = 0;
+  size_t offset = 0;
+};
+
+// whether parsing stopped because the markup runs past end rather than
+// because it is malformed
+inline bool is_cut_off(const xml_parse_error &e, const char *end) {
+  const char *pos = e.pos();
+  if (pos == end) {
+    return true;
+  }
+  return e.code() == xml_errc::expected_gt && pos != nullptr && pos < end &&
+         std::memchr(pos, '>', static_cast<size_t>(end - pos)) == nullptr;
+}
+
+// advance it past the next piece of markup in [it, end). returns true with
+// it past the start tag when that is a start tag of name, and [it, last) is
+// then the whole content of the element. throws when the markup is cut off
+// by end, without having modified the buffer, it is then left at the '<' of
+// the markup and scan lets the next call skip what was already searched
+inline bool next_streamed(char *&it, char *end, std::string_view name,
+                          xml_tag &tag, char *&last, streamed_scan &scan) {
+  char *lt = find_xml_char(it, end, '<');
+  if (lt == nullptr) {
+    it = end;
+    return false;
+  }
+  it = lt;
+  if (it + 1 == end) {
+    throw xml_parse_error(xml_errc::unexpected_end, end);
+  }
+  if (it[1] == '/') {
+    char *gt = find_xml_char(it, end, '>');
+    if (gt == nullptr) {
+      throw xml_parse_error(xml_errc::expected_gt, it);
+    }
+    it = gt + 1;
+    return false;
+  }
+  if (it[1] == '!' || it[1] == '?') {
+    char *p = it;
+    skip_markup(p, end);
+    it = p;
+    return false;
+  }
+  char *p = it + 1;
+  tag = parse_start_tag(p, end);
+  if (tag.name != name) {
+    it = p;
+    return false;
+  }
+  last = p;
+  if (!tag.empty) {
+    size_t depth = 1;
+    if (scan.depth != 0) {
+      last = it + scan.offset;
+      depth = scan.depth;
+    }
+    try {
+      skip_element(last, end, depth);
+    } catch (xml_parse_error &) {
+      scan = {depth, static_cast<size_t>(last - it)};
+      throw;
+    }
+    scan = {};
+  }
+  it = p;
+  return true;
+}
+} // namespace detail
+
+// children of node are walked once and dispatched to members by name, so
+// they may come in any order and repeated elements need not be adjacent
+template <typename T>
+inline void do_read(rapidxml::xml_node<char> *node, T &&t) {
+  using U = std::remove_cvref_t<T>;
+  static_assert(is_reflection_v<U>, "must be refletable object");
+  constexpr auto &info = detail::element_info_v<U>;
+  constexpr auto &readers = detail::dom_readers_v<U>;
+  for_each(t, [&](auto member_ptr, auto) {
+    using M = std::remove_cvref_t<decltype(t.*member_ptr)>;
+    if constexpr (is_map_container<M>::value) {
+      parse_attribute(node, t.*member_ptr);
     }
   });
+
+  std::array<bool, info.size()> seen{};
+  bool first_cdata = true;
+  for (auto c = node->first_node(); c; c = c->next_sibling()) {
+    if (c->type() == rapidxml::node_cdata) {
+      detail::read_cdata(t, std::string_view(c->value(), c->value_size()),
+                         first_cdata);
+      first_cdata = false;
+    } else if (c->type() == rapidxml::node_element) {
+      const int j = detail::find_element<U>(
+          std::string_view(c->name(), c->name_size()));
+      if (j >= 0 && (!seen[j] || info[j].repeated)) {
+        seen[j] = true;
+        readers[j](t, c);
+      }
+    }
+  }
+  detail::check_missing<U>(seen, [node] { return node->name(); });
+}
+
+namespace detail {
+inline xml_error to_xml_error(const xml_parse_error &e, const char *begin,
+                              const char *end) {
+  const char *pos = e.pos();
+  xml_error err{e.code(), e.element(),
+                pos != nullptr && pos >= begin && pos <= end
+                    ? static_cast<size_t>(pos - begin)
+                    : 0};
+  err.path_size = (std::min)(e.depth(), xml_error::max_path);
+  for (size_t i = 0; i < err.path_size; ++i) {
+    err.path[i] = e.element(err.path_size - 1 - i);
+  }
+  return err;
+}
+
+inline void set_last_read_err(const xml_error &err) {
+  g_xml_read_err = xml_errc_message(err.code);
+  if (err.path_size != 0) {
+    g_xml_read_err.append(" in <");
+    for (size_t i = 0; i < err.path_size; ++i) {
+      if (i != 0) {
+        g_xml_read_err.push_back('/');
+      }
+      g_xml_read_err.append(err.path[i]);
+    }
+    g_xml_read_err.append(">");
+  } else if (!err.element.empty()) {
+    g_xml_read_err.append(" in <").append(err.element).append(">");
+  }
+  g_xml_read_err.append(" at offset ").append(std::to_string(err.offset));
+}
+
+template <int Flags, typename T>
+inline bool read_document(T &t, char *begin, char *end, xml_error &err) {
+  try {
+    parse_document<Flags>(t, begin, end);
+    err = {};
+    return true;
+  } catch (xml_parse_error &e) {
+    err = to_xml_error(e, begin, end);
+  }
+  return false;
+}
+
+// f(i) for i in [0, n), split into contiguous ranges over up to threads
+// threads. the first exception in index order is rethrown after all of them
+// are done
+template <typename F>
+inline void parallel_for(size_t n, unsigned threads, const F &f) {
+  const size_t parts = (std::min)(static_cast<size_t>(threads), n);
+  if (parts <= 1) {
+    for (size_t i = 0; i < n; ++i) {
+      f(i);
+    }
+    return;
+  }
+  std::vector<std::exception_ptr> errors(parts);
+  auto run = [&](size_t part) {
+    try {
+      for (size_t i = n * part / parts; i < n * (part + 1) / parts; ++i) {
+        f(i);
+      }
+    } catch (...) {
+      errors[part] = std::current_exception();
+    }
+  };
+  {
+    const auto diagnostics = g_xml_diagnostics;
+    std::vector<std::jthread> workers;
+    workers.reserve(parts - 1);
+    for (size_t part = 1; part < parts; ++part) {
+      workers.emplace_back([&, part] {
+        g_xml_diagnostics = diagnostics;
+        run(part);
+      });
+    }
+    run(0);
+  }
+  for (auto &e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+// the elements of each deferrable member are appended in document order,
+// every one is parsed into its own slot so no two threads share a value
+template <int Flags, typename T>
+inline void parse_deferred(T &t, std::string_view root,
+                           const std::vector<deferred_element> &deferred,
+                           unsigned threads) {
+  constexpr auto &members = element_members_v<T>;
+  [&]<size_t... J>(std::index_sequence<J...>) {
+    (
+        [&] {
+          using U = member_t<T, members[J]>;
+          if constexpr (is_deferrable_member<U>()) {
+            std::vector<const deferred_element *> found;
+            for (const auto &d : deferred) {
+              if (d.member == J) {
+                found.push_back(&d);
+              }
+            }
+            if (found.empty()) {
+              return;
+            }
+            auto &value =
+                t.*std::get<members[J]>(Reflect_members<T>::apply_impl());
+            const size_t base = value.size();
+            value.resize(base + found.size());
+            parallel_for(found.size(), threads, [&](size_t i) {
+              char *it = found[i]->content;
+              try {
+                parse_struct<Flags>(value[base + i], found[i]->tag, it,
+                                    found[i]->end);
+              } catch (xml_parse_error &e) {
+                e.push_element(root);
+                throw;
+              }
+            });
+          }
+        }(),
+        ...);
+  }
+  (std::make_index_sequence<members.size()>{});
+}
+} // namespace detail
+
+// err tells why and where parsing stopped, nothing is printed or allocated
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml(T &&t, char *buf, xml_error &err) {
+  return detail::read_document<Flags>(t, buf, buf + std::strlen(buf), err);
 }
 
 template <int Flags = 0, typename T,
           typename = std::enable_if_t<is_reflection<T>::value>>
 inline bool from_xml(T &&t, char *buf) {
-  if (!g_xml_read_err.empty()) {
-    g_xml_read_err.clear();
+  xml_error err;
+  if (!from_xml<Flags>(t, buf, err)) {
+    detail::set_last_read_err(err);
+    return false;
   }
-  try {
-    rapidxml::xml_document<> doc;
-    doc.parse<Flags>(buf);
+  g_xml_read_err.clear();
+  return true;
+}
 
-    auto fisrt_node = doc.first_node();
-    if (fisrt_node)
-      do_read(fisrt_node, t);
+// parse a buffer that is never written to, such as a read-only mapping.
+// strings without entity references are viewed in place, decoded ones are
+// allocated from resource and parsing fails if one is met without it
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml(T &&t, std::string_view xml, xml_error &err,
+                     std::pmr::memory_resource *resource = nullptr) {
+  detail::arena_scope scope(resource);
+  auto buf = const_cast<char *>(xml.data());
+  return detail::read_document<Flags | detail::const_input>(
+      t, buf, buf + xml.size(), err);
+}
 
-    return true;
-  } catch (std::exception &e) {
-    g_xml_read_err = e.what();
-    std::cout << e.what() << "\n";
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml(T &&t, std::string_view xml,
+                     std::pmr::memory_resource *resource = nullptr) {
+  xml_error err;
+  if (!from_xml<Flags>(t, xml, err, resource)) {
+    detail::set_last_read_err(err);
+    return false;
   }
+  g_xml_read_err.clear();
+  return true;
+}
 
+// same as from_xml, but the elements of vector of struct members of the root
+// are first located and then parsed on up to threads threads, each writing
+// its own slots so the result is in document order. the diagnostics
+// callback of the calling thread is used by all of them
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml_parallel(T &&t, char *buf, xml_error &err,
+                              unsigned threads = 0) {
+  if (threads == 0) {
+    threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+  }
+  char *end = buf + std::strlen(buf);
+  try {
+    std::vector<detail::deferred_element> deferred;
+    const auto root = detail::parse_document<Flags>(t, buf, end, &deferred);
+    detail::parse_deferred<Flags>(t, root, deferred, threads);
+    err = {};
+    return true;
+  } catch (xml_parse_error &e) {
+    err = detail::to_xml_error(e, buf, end);
+  }
   return false;
 }
 
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml_parallel(T &&t, char *buf, unsigned threads = 0) {
+  xml_error err;
+  if (!from_xml_parallel<Flags>(t, buf, err, threads)) {
+    detail::set_last_read_err(err);
+    return false;
+  }
+  g_xml_read_err.clear();
+  return true;
+}
+
+// read every element called name from in, at any depth, into a T and pass
+// it to f. the same T is cleared and reused for each element and only the
+// unread part of the stream up to the end of the current element is kept in
+// memory. string_view and cdata_t members are valid until f returns
+template <typename T, typename F>
+inline bool from_xml_each(std::istream &in, std::string_view name, F &&f,
+                          size_t chunk_size = 64 * 1024) {
+  std::string buf;
+  size_t pos = 0;
+  auto fill = [&] {
+    buf.erase(0, pos);
+    pos = 0;
+    const size_t size = buf.size();
+    buf.resize(size + chunk_size);
+    in.read(buf.data() + size, static_cast<std::streamsize>(chunk_size));
+    buf.resize(size + static_cast<size_t>(in.gcount()));
+    return in.gcount() > 0;
+  };
+
+  T t = T();
+  fill();
+  // the offset of buf in the stream
+  size_t consumed = 0;
+  detail::streamed_scan scan;
+  while (true) {
+    char *begin = buf.data();
+    char *end = begin + buf.size();
+    char *it = begin + pos;
+    try {
+      if (it == end) {
+        consumed += pos;
+        if (!fill()) {
+          g_xml_read_err.clear();
+          return true;
+        }
+        continue;
+      }
+
+      detail::xml_tag tag;
+      char *last = nullptr;
+      bool found;
+      try {
+        found = detail::next_streamed(it, end, name, tag, last, scan);
+      } catch (xml_parse_error &e) {
+        if (!detail::is_cut_off(e, end)) {
+          throw;
+        }
+        // the markup continues past what has been read so far, it is at its
+        // start and everything before it is dropped
+        pos = static_cast<size_t>(it - begin);
+        consumed += pos;
+        if (!fill()) {
+          throw xml_parse_error(e.code(), buf.data() + buf.size());
+        }
+        continue;
+      }
+      if (found) {
+        detail::reset_value(t);
+        detail::parse_struct<0>(t, tag, it, last);
+        f(t);
+      }
+      pos = static_cast<size_t>(it - begin);
+    } catch (xml_parse_error &e) {
+      begin = buf.data();
+      auto err = detail::to_xml_error(e, begin, begin + buf.size());
+      err.offset += consumed;
+      detail::set_last_read_err(err);
+      return false;
+    }
+  }
+}
+
 inline std::string get_last_read_err() { return g_xml_read_err; }
 } // namespace iguana
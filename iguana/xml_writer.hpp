@@ -4,31 +4,148 @@
 
 #ifndef IGUANA_XML17_HPP
 #define IGUANA_XML17_HPP
+#include "detail/int_to_chars.hpp"
+#include "json_util.hpp"
 #include "reflection.hpp"
 #include "type_traits.hpp"
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <functional>
 #include <msstl/charconv.hpp>
-#include <rapidxml_print.hpp>
 #include <string.h>
 
 namespace iguana {
-inline std::string g_xml_write_err;
-template <typename Stream, typename T>
-inline void to_xml_impl(Stream &s, T &&t, std::string_view name = "");
+namespace detail {
+// the start and end tag of an element, attributes go before the last
+// character of start
+struct xml_tags {
+  std::string_view start;
+  std::string_view end;
+};
+
+// "<name></name>", the first '_' becomes ':' for a namespace_t member
+template <size_t N>
+constexpr std::array<char, 2 * N + 5> make_xml_tags(std::string_view name,
+                                                    bool ns) {
+  std::array<char, 2 * N + 5> tags{};
+  size_t n = 0;
+  tags[n++] = '<';
+  for (char c : name) {
+    tags[n++] = c;
+  }
+  tags[n++] = '>';
+  tags[n++] = '<';
+  tags[n++] = '/';
+  for (char c : name) {
+    tags[n++] = c;
+  }
+  tags[n++] = '>';
+  if (auto pos = name.find('_'); ns && pos != std::string_view::npos) {
+    tags[1 + pos] = ':';
+    tags[N + 4 + pos] = ':';
+  }
+  return tags;
+}
+
+// the first character of [it, end) that has to be escaped in text, or in an
+// attribute value when Attr, eight bytes are tested at once
+template <bool Attr>
+inline const char *find_xml_escape(const char *it, const char *end) noexcept {
+  constexpr uint64_t amps = 0x2626262626262626;
+  constexpr uint64_t lts = 0x3c3c3c3c3c3c3c3c;
+  constexpr uint64_t gts = 0x3e3e3e3e3e3e3e3e;
+  constexpr uint64_t quotes = 0x2222222222222222;
+  constexpr uint64_t apos = 0x2727272727272727;
+  for (; end - it >= 8; it += 8) {
+    const auto chunk = load_chunk(it);
+    auto mask = has_zero_byte(chunk ^ amps) | has_zero_byte(chunk ^ lts) |
+                has_zero_byte(chunk ^ gts);
+    if constexpr (Attr) {
+      mask |= has_zero_byte(chunk ^ quotes) | has_zero_byte(chunk ^ apos);
+    }
+    if (mask != 0) {
+      return it + (std::countr_zero(mask) >> 3);
+    }
+  }
+  for (; it < end; ++it) {
+    const char c = *it;
+    if (c == '&' || c == '<' || c == '>' ||
+        (Attr && (c == '"' || c == '\''))) {
+      return it;
+    }
+  }
+  return end;
+}
+
+// clean runs are appended in one piece
+template <bool Attr, typename Stream>
+inline void render_xml_escaped(Stream &ss, std::string_view str) {
+  const char *it = str.data();
+  const char *end = it + str.size();
+  while (true) {
+    const char *start = it;
+    it = find_xml_escape<Attr>(it, end);
+    ss.append(start, static_cast<size_t>(it - start));
+    if (it == end) {
+      break;
+    }
+    switch (*it) {
+    case '&':
+      ss.append("&amp;", 5);
+      break;
+    case '<':
+      ss.append("&lt;", 4);
+      break;
+    case '>':
+      ss.append("&gt;", 4);
+      break;
+    case '"':
+      ss.append("&quot;", 6);
+      break;
+    default:
+      ss.append("&apos;", 6);
+    }
+    ++it;
+  }
+}
+
+template <size_t M>
+constexpr xml_tags to_xml_tags(const std::array<char, M> &tags) {
+  constexpr size_t N = (M - 5) / 2;
+  return {std::string_view(tags.data(), N + 2),
+          std::string_view(tags.data() + N + 2, N + 3)};
+}
+
+template <typename T, size_t I, bool Namespace>
+inline constexpr auto member_tags_v = make_xml_tags<get_name<T, I>().size()>(
+    std::string_view(get_name<T, I>().data(), get_name<T, I>().size()),
+    Namespace);
+
+template <typename T>
+inline constexpr auto struct_tags_v =
+    make_xml_tags<get_name<T>().size()>(get_name<T>(), false);
+} // namespace detail
+
+template <bool Pretty, typename Stream, typename T>
+inline void to_xml_impl(Stream &s, T &&t, const detail::xml_tags &tags,
+                        size_t depth);
 
 class any_t;
 class cdata_t;
-constexpr inline size_t find_underline(const char *);
 
 template <typename Stream, typename T>
 inline std::enable_if_t<std::is_arithmetic_v<T>> render_xml_value(Stream &ss,
                                                                   T &value) {
   char temp[40];
-  auto [p, ec] = msstl::to_chars(temp, temp + sizeof(temp), value);
-  const auto n = std::distance(temp, p);
-  ss.append(temp, n);
+  if constexpr (std::is_integral_v<T>) {
+    auto p = detail::to_chars(temp, value);
+    ss.append(temp, p - temp);
+  } else {
+    auto [p, ec] = msstl::to_chars(temp, temp + sizeof(temp), value);
+    const auto n = std::distance(temp, p);
+    ss.append(temp, n);
+  }
 }
 
 template <typename Stream> inline void render_xml_value(Stream &ss, bool s) {
@@ -40,18 +157,18 @@ template <typename Stream> inline void render_xml_value(Stream &ss, bool s) {
 }
 
 template <typename Stream> inline void render_xml_value(Stream &ss, char s) {
-  ss.push_back(s);
+  detail::render_xml_escaped<false>(ss, std::string_view(&s, 1));
 }
 
 template <typename Stream, typename T>
 inline std::enable_if_t<is_str_v<std::decay_t<T>>> render_xml_value(Stream &ss,
                                                                     T &&s) {
-  ss.append(s.data(), s.size());
+  detail::render_xml_escaped<false>(ss, std::string_view(s.data(), s.size()));
 }
 
 template <typename Stream>
 inline void render_xml_value(Stream &ss, const char *s) {
-  ss.append(s, strlen(s));
+  detail::render_xml_escaped<false>(ss, std::string_view(s, strlen(s)));
 }
 
 template <typename Stream, typename T>
@@ -63,76 +180,95 @@ inline void render_xml_value(Stream &ss, const std::optional<T> &s) {
 
 template <typename Stream>
 inline void render_xml_value(Stream &ss, const any_t &t) {
-  ss.append(t.get_value().data(), t.get_value().size());
-}
-
-template <typename Stream> inline void render_tail(Stream &ss, const char *s) {
-  ss.push_back('<');
-  ss.push_back('/');
-  ss.append(s, strlen(s));
-  ss.push_back('>');
-}
-
-template <typename Stream> inline void render_head(Stream &ss, const char *s) {
-  ss.push_back('<');
-  ss.append(s, strlen(s));
-  ss.push_back('>');
+  detail::render_xml_escaped<false>(ss, t.get_value());
 }
 
 template <typename Stream, typename T>
-inline void render_xml_attr(Stream &ss, std::string_view name, T &&attr) {
+inline void render_xml_attr(Stream &ss, const detail::xml_tags &tags,
+                            T &&attr) {
   static_assert(is_map_container<std::decay_t<T>>::value,
                 "must be map container");
-  ss.append("<").append(name);
+  ss.append(tags.start.data(), tags.start.size() - 1);
   for (auto &[k, v] : attr) {
     ss.append(" ").append(k).append("=\"");
-    render_xml_value(ss, v);
+    using V = std::decay_t<decltype(v)>;
+    if constexpr (is_str_v<V>) {
+      detail::render_xml_escaped<true>(ss, std::string_view(v.data(), v.size()));
+    } else if constexpr (std::is_same_v<V, any_t>) {
+      detail::render_xml_escaped<true>(ss, v.get_value());
+    } else {
+      render_xml_value(ss, v);
+    }
     ss.append("\"");
   }
-  ss.append(">");
+  ss.push_back('>');
 }
 
-template <typename Stream, typename T>
-inline void render_xml_node(Stream &ss, std::string_view name, T &&item) {
+template <typename Stream>
+inline void render_indent(Stream &ss, size_t depth) {
+  constexpr std::string_view tabs = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+  for (; depth > tabs.size(); depth -= tabs.size()) {
+    ss.append(tabs.data(), tabs.size());
+  }
+  ss.append(tabs.data(), depth);
+}
+
+template <bool Pretty, typename Stream, typename T>
+inline void render_xml_node(Stream &ss, const detail::xml_tags &tags, T &&item,
+                            size_t depth) {
   using U = std::decay_t<T>;
+  if constexpr (Pretty) {
+    render_indent(ss, depth);
+  }
   if constexpr (is_std_pair_v<U>) {
-    render_xml_attr(ss, name, item.second);
+    render_xml_attr(ss, tags, item.second);
     render_xml_value(ss, item.first);
-    render_tail(ss, name.data());
+    ss.append(tags.end.data(), tags.end.size());
   } else if constexpr (std::is_same_v<cdata_t, U>) {
     ss.append("<![CDATA[").append(item.get()).append("]]>");
   } else {
-    render_head(ss, name.data());
+    ss.append(tags.start.data(), tags.start.size());
     render_xml_value(ss, std::forward<T>(item));
-    render_tail(ss, name.data());
+    ss.append(tags.end.data(), tags.end.size());
+  }
+  if constexpr (Pretty) {
+    ss.push_back('\n');
   }
 }
 
-template <typename Stream, typename T>
-inline void render_xml_value0(Stream &ss, const T &v, std::string_view name) {
+template <bool Pretty, typename Stream, typename T>
+inline void render_xml_value0(Stream &ss, const T &v,
+                              const detail::xml_tags &tags, size_t depth) {
   for (auto &item : v) {
     using item_type = std::decay_t<decltype(item)>;
     if constexpr (is_reflection_v<item_type>) {
-      to_xml_impl(ss, item, name);
+      to_xml_impl<Pretty>(ss, item, tags, depth);
     } else {
-      render_xml_node(ss, name, item);
+      render_xml_node<Pretty>(ss, tags, item, depth);
     }
   }
 }
 
-template <typename Stream, typename T>
-inline void to_xml_impl(Stream &s, T &&t, std::string_view name) {
-  if (name.empty()) {
-    name = iguana::get_name<T>();
-  }
-  constexpr auto Idx = get_type_index<is_map_container, std::decay_t<T>>();
-  if constexpr (Idx != iguana::get_value<std::decay_t<T>>()) {
-    auto attr_value = get<Idx>(t);
-    render_xml_attr(s, name, attr_value);
+// when Pretty every element is on its own line, indented by one tab per
+// level of depth
+template <bool Pretty, typename Stream, typename T>
+inline void to_xml_impl(Stream &s, T &&t, const detail::xml_tags &tags,
+                        size_t depth) {
+  using U = std::decay_t<T>;
+  if constexpr (Pretty) {
+    render_indent(s, depth);
+  }
+  constexpr auto Idx = get_type_index<is_map_container, U>();
+  if constexpr (Idx != iguana::get_value<U>()) {
+    render_xml_attr(s, tags, get<Idx>(t));
   } else {
-    s.append("<").append(name).append(">");
+    s.append(tags.start.data(), tags.start.size());
   }
-  for_each(std::forward<T>(t), [&t, &s](const auto v, auto i) {
+  if constexpr (Pretty) {
+    s.push_back('\n');
+  }
+  const size_t child_depth = depth + 1;
+  for_each(std::forward<T>(t), [&t, &s, child_depth](const auto v, auto i) {
     using M = decltype(iguana_reflect_members(std::forward<T>(t)));
     constexpr auto Idx = decltype(i)::value;
     constexpr auto Count = M::value();
@@ -140,41 +276,50 @@ inline void to_xml_impl(Stream &s, T &&t, std::string_view name) {
 
     using type_v = decltype(std::declval<T>().*std::declval<decltype(v)>());
     using type_u = std::decay_t<type_v>;
+    constexpr auto member_tags = detail::to_xml_tags(
+        detail::member_tags_v<U, Idx, is_namespace_v<type_u>>);
     if constexpr (!is_reflection<type_v>::value) {
       if constexpr (is_map_container<type_u>::value) {
         return;
       } else if constexpr (is_namespace_v<type_u>) {
-        constexpr auto name = get_name<T, Idx>();
-        constexpr auto index_ul = find_underline(name.data());
-        std::string ns(name.data(), name.size());
-        ns[index_ul] = ':';
         if constexpr (is_reflection<typename type_u::value_type>::value) {
-          to_xml_impl(s, (t.*v).get(), ns);
+          to_xml_impl<Pretty>(s, (t.*v).get(), member_tags, child_depth);
         } else {
-          render_xml_node(s, ns, (t.*v).get());
+          render_xml_node<Pretty>(s, member_tags, (t.*v).get(), child_depth);
         }
       } else if constexpr (is_std_optinal_v<type_u>) {
         if ((t.*v).has_value()) {
           using value_type = typename type_u::value_type;
           if constexpr (!is_str_v<value_type> &&
                         is_container<value_type>::value) {
-            std::string_view sv = get_name<T, Idx>().data();
-            render_xml_value0(s, *(t.*v), sv);
+            render_xml_value0<Pretty>(s, *(t.*v), member_tags, child_depth);
           } else {
-            render_xml_node(s, get_name<T, Idx>().data(), *(t.*v));
+            render_xml_node<Pretty>(s, member_tags, *(t.*v), child_depth);
           }
         }
       } else if constexpr (!is_str_v<type_u> && is_container<type_u>::value) {
-        std::string_view sv = get_name<T, Idx>().data();
-        render_xml_value0(s, t.*v, sv);
+        render_xml_value0<Pretty>(s, t.*v, member_tags, child_depth);
       } else {
-        render_xml_node(s, get_name<T, Idx>().data(), t.*v);
+        render_xml_node<Pretty>(s, member_tags, t.*v, child_depth);
       }
     } else {
-      to_xml_impl(s, t.*v, get_name<T, Idx>().data());
+      to_xml_impl<Pretty>(s, t.*v, member_tags, child_depth);
     }
   });
-  s.append("</").append(name).append(">");
+  if constexpr (Pretty) {
+    render_indent(s, depth);
+  }
+  s.append(tags.end.data(), tags.end.size());
+  if constexpr (Pretty) {
+    s.push_back('\n');
+  }
+}
+
+template <bool Pretty = false, typename Stream, typename T>
+inline void to_xml_impl(Stream &s, T &&t) {
+  to_xml_impl<Pretty>(
+      s, std::forward<T>(t),
+      detail::to_xml_tags(detail::struct_tags_v<std::decay_t<T>>), 0);
 }
 
 template <typename Stream, typename T,
@@ -183,27 +328,23 @@ inline void to_xml(T &&t, Stream &s) {
   to_xml_impl(s, std::forward<T>(t));
 }
 
-template <int Flags = 0, typename Stream, typename T,
+// the indentation is written in the same pass as the elements, this cannot
+// fail and always returns true
+template <typename Stream, typename T,
           typename = std::enable_if_t<is_reflection<T>::value>>
 inline bool to_xml_pretty(T &&t, Stream &s) {
-  to_xml_impl(s, std::forward<T>(t));
-
-  bool r = true;
-  try {
-    rapidxml::xml_document<> doc;
-    doc.parse<Flags>(s.data());
-    std::string ss;
-    rapidxml::print(std::back_inserter(ss), doc);
-    s = std::move(ss);
-  } catch (std::exception &e) {
-    r = false;
-    g_xml_write_err = e.what();
-    std::cerr << e.what() << "\n";
-  }
+  to_xml_impl<true>(s, std::forward<T>(t));
+  return true;
+}
 
-  return r;
+template <int Flags, typename Stream, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+[[deprecated("rapidxml print flags are ignored, call to_xml_pretty(t, s)")]]
+inline bool to_xml_pretty(T &&t, Stream &s) {
+  return to_xml_pretty(std::forward<T>(t), s);
 }
 
-inline std::string get_last_write_err() { return g_xml_write_err; }
+[[deprecated("to_xml and to_xml_pretty cannot fail, this is always empty")]]
+inline std::string get_last_write_err() { return {}; }
 } // namespace iguana
 #endif // IGUANA_XML17_HPP
\ No newline at end of file
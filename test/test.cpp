@@ -3,6 +3,8 @@
 #include <vector>
 #define DOCTEST_CONFIG_IMPLEMENT
 #include "doctest.h"
+#include "iguana/json_dom.hpp"
+#include "iguana/json_pointer.hpp"
 #include "iguana/json_reader.hpp"
 #include "iguana/prettify.hpp"
 #include "iguana/value.hpp"
@@ -172,6 +174,294 @@ TEST_CASE("test from issues") {
   std::cout << std::boolalpha << test1.error << std::endl;
 }
 
+TEST_CASE("test dom to_json") {
+  std::string_view str =
+      R"({"a":[1,2.5,true,null,"x\ny"],"b":{"c":"d"},"e":{}})";
+  iguana::jvalue val;
+  iguana::parse(val, str.begin(), str.end());
+
+  std::string out;
+  iguana::to_json(val, out, true);
+  iguana::jvalue val1;
+  iguana::parse(val1, out.begin(), out.end());
+  CHECK(val1 == val);
+  CHECK(val1.at<iguana::jarray>("a")[4].to_string() == "x\ny");
+}
+
+TEST_CASE("test dom object") {
+  std::string_view str = R"({"z":1,"a":2,"m":3})";
+  iguana::jvalue val;
+  iguana::parse(val, str.begin(), str.end());
+  std::string out;
+  iguana::to_json(val, out);
+  CHECK(out == R"({"z":1,"a":2,"m":3})");
+
+  iguana::jobject obj;
+  for (int i = 0; i < 40; ++i) {
+    obj.emplace(std::to_string(39 - i), i);
+  }
+  CHECK(obj.size() == 40);
+  CHECK(obj.begin()->first == "39");
+  static_assert(
+      std::is_const_v<std::remove_reference_t<decltype(obj.begin()->first)>>);
+  for (int i = 0; i < 40; ++i) {
+    CHECK(obj.at(std::to_string(i)).to_int() == 39 - i);
+  }
+  CHECK(!obj.try_emplace("7", 0).second);
+  obj["40"] = 40;
+  CHECK(obj.contains("40"));
+  CHECK(obj.erase("0") == 1);
+  CHECK(obj.find("0") == obj.end());
+  CHECK(obj.at("1").to_int() == 38);
+  CHECK_THROWS(obj.at("0"));
+  for (int i = 1; i < 30; ++i) {
+    CHECK(obj.erase(std::to_string(i)) == 1);
+    CHECK(obj.at(std::to_string(i + 1)).to_int() == 38 - i);
+  }
+  CHECK(obj.size() == 11);
+  CHECK(obj.at("40").to_int() == 40);
+}
+
+TEST_CASE("test dom find") {
+  std::string_view str =
+      R"({"features":[{"geometry":{"type":"Point","xy":[1.5,2]}}],"n":3})";
+  iguana::jvalue val;
+  iguana::parse(val, str.begin(), str.end());
+
+  const auto *type = val.find("features", 0, "geometry", "type");
+  REQUIRE(type != nullptr);
+  CHECK(*type->get_if<std::string>() == "Point");
+  CHECK(val.find("features", 0, "geometry", "xy", 1)->as<int>() != nullptr);
+  CHECK(val.find("features", 1) == nullptr);
+  CHECK(val.find("n", "x") == nullptr);
+  CHECK(val.find("missing") == nullptr);
+  CHECK(val.find(0) == nullptr);
+  CHECK(val.find("n")->as<double>() == nullptr);
+
+  // references into the tree, no copies
+  const auto &features = val.at<iguana::jarray>("features");
+  CHECK(&features == val.find("features")->get_if<iguana::jarray>());
+  val.find("n")->emplace<int>(4);
+  CHECK(val.at<int>("n") == 4);
+  CHECK_THROWS_WITH(val.at<double>("n"), "int type");
+}
+
+TEST_CASE("test compact dom") {
+  static_assert(sizeof(iguana::jnode) == 16);
+  std::string_view str =
+      R"({"a":[1,-2.5,true,null,"x\"y"], "b" : {"c":{}}, "d":[], "e":12345678901})";
+  iguana::jdocument doc;
+  iguana::parse(doc, str);
+
+  const auto &root = doc.root();
+  CHECK(root.is_object());
+  CHECK(root.size() == 4);
+  CHECK(root.find("a", 0)->to_int() == 1);
+  CHECK(root.find("a", 1)->to_double() == -2.5);
+  CHECK(root.find("a", 2)->to_bool());
+  CHECK(root.find("a", 3)->is_null());
+  CHECK(root.find("a", 4)->to_string() == "x\"y");
+  CHECK(root.find("b", "c")->is_object());
+  CHECK(root.find("d")->to_array().empty());
+  CHECK(root.find("e")->to_int() == 12345678901);
+  CHECK(root.find("a", 5) == nullptr);
+  CHECK_THROWS_WITH(root.find("a")->to_string(), "array type");
+
+  std::string out;
+  iguana::to_json(doc, out);
+  CHECK(out ==
+        R"({"a":[1,-2.5E0,true,null,"x\"y"],"b":{"c":{}},"d":[],"e":12345678901})");
+
+  std::string_view bad = R"({"a":[1,2})";
+  std::error_code ec;
+  iguana::parse(doc, bad, ec);
+  CHECK(ec);
+
+  std::string_view nums =
+      R"([9007199254740993, 1.0, 2e3, -7, 99999999999999999999])";
+  iguana::parse(doc, nums);
+  CHECK(doc.root().find(0)->to_int() == 9007199254740993);
+  CHECK(doc.root().find(1)->to_double() == 1.0);
+  CHECK(doc.root().find(2)->to_double() == 2000);
+  CHECK(doc.root().find(3)->to_int() == -7);
+  CHECK(doc.root().find(4)->to_double() == 1e20);
+}
+
+struct dom_t {
+  std::string name;
+  std::vector<point_t> points;
+  std::map<int, std::string> tags;
+  std::optional<int> opt;
+  std::tuple<int, std::string> tup;
+  iguana::jvalue extra;
+};
+REFLECTION(dom_t, name, points, tags, opt, tup, extra);
+
+TEST_CASE("test from_dom and to_dom") {
+  std::string_view str = R"({"name":"tom","points":[{"x":1,"y":2.5}],
+      "tags":{"1":"a","2":"b"},"opt":null,"tup":[3,"c"],
+      "extra":{"any":[true]}})";
+  iguana::jvalue val;
+  iguana::parse(val, str);
+
+  dom_t t;
+  iguana::from_dom(t, val);
+  CHECK(t.name == "tom");
+  CHECK(t.points.size() == 1);
+  CHECK(t.points[0].x == 1);
+  CHECK(t.points[0].y == 2.5);
+  CHECK(t.tags.at(2) == "b");
+  CHECK(!t.opt);
+  CHECK(std::get<1>(t.tup) == "c");
+  CHECK(t.extra.find("any", 0)->to_bool());
+
+  iguana::jvalue dom = iguana::to_dom(t);
+  CHECK(dom.at<std::string>("name") == "tom");
+  CHECK(dom.find("points", 0, "y")->to_double() == 2.5);
+  CHECK(dom.find("tags", "1")->to_string() == "a");
+  CHECK(dom.find("opt")->is_null());
+  CHECK(dom.find("tup", 0)->to_int() == 3);
+
+  dom_t t1;
+  iguana::from_dom(t1, std::move(dom));
+  CHECK(t1.name == "tom");
+  CHECK(t1.tags == t.tags);
+  CHECK(t1.extra == t.extra);
+
+  std::string s1, s2;
+  iguana::to_json(t, s1);
+  iguana::to_json(t1, s2);
+  CHECK(s1 == s2);
+
+  std::vector<iguana::fixed_t<double, 2>> prices{{1.25}, {-3}};
+  iguana::jvalue fixed = iguana::to_dom(prices);
+  CHECK(fixed.find(0)->to_double() == 1.25);
+  CHECK(fixed.find(1)->to_double() == -3);
+  std::vector<iguana::fixed_t<double, 2>> prices1;
+  iguana::from_dom(prices1, fixed);
+  CHECK(prices1 == prices);
+
+  std::error_code ec;
+  iguana::from_dom(t1, iguana::jvalue(1), ec);
+  CHECK(ec);
+
+  point_t p;
+  iguana::parse(val, std::string_view(R"({"x":3.0,"y":1})"));
+  iguana::from_dom(p, val, ec);
+  CHECK(!ec);
+  CHECK(p.x == 3);
+  iguana::parse(val, std::string_view(R"({"x":2.7,"y":1})"));
+  iguana::from_dom(p, val, ec);
+  CHECK(ec.message() == "Expected integer");
+  iguana::parse(val, std::string_view(R"({"x":1e30,"y":1})"));
+  CHECK_THROWS_WITH(iguana::from_dom(p, val), "Expected integer");
+}
+
+struct envelope_t {
+  int id;
+  iguana::raw_json payload;
+  std::vector<iguana::raw_json> rest;
+};
+REFLECTION(envelope_t, id, payload, rest);
+
+TEST_CASE("test raw_json") {
+  std::string str = R"({"id": 7, "payload" : {"a": [1, {"b": "}"}]} ,
+      "rest": ["x" , 2.5 , null, [ ] ]})";
+  envelope_t t;
+  iguana::from_json(t, str);
+  CHECK(t.id == 7);
+  CHECK(t.payload.str == R"({"a": [1, {"b": "}"}]})");
+  CHECK(t.rest.size() == 4);
+  CHECK(t.rest[0].str == R"("x")");
+  CHECK(t.rest[1].str == "2.5");
+  CHECK(t.rest[3].str == "[ ]");
+
+  std::string out;
+  iguana::to_json(t, out);
+  CHECK(out ==
+        R"({"id":7,"payload":{"a": [1, {"b": "}"}]},"rest":["x",2.5,null,[ ]]})");
+}
+
+struct lazy_t {
+  int id;
+  iguana::lazy<point_t> p;
+  iguana::lazy<std::vector<int>> v;
+};
+REFLECTION(lazy_t, id, p, v);
+
+TEST_CASE("test lazy") {
+  std::string str = R"({"id":1,"p": {"x": 2, "y": 3.5} ,"v":[1, 2]})";
+  lazy_t t;
+  iguana::from_json(t, str);
+  CHECK(!t.p.is_parsed());
+  CHECK(t.p.raw() == R"({"x": 2, "y": 3.5})");
+
+  const auto &ct = t;
+  CHECK(ct.p->x == 2);
+  CHECK(ct.p->y == 3.5);
+  CHECK(t.p.is_parsed());
+  CHECK(!t.p.is_dirty());
+
+  // untouched or only read members are written back as they were
+  std::string out;
+  iguana::to_json(t, out);
+  CHECK(out == R"({"id":1,"p":{"x": 2, "y": 3.5},"v":[1, 2]})");
+
+  t.v->push_back(3);
+  CHECK(t.v.is_dirty());
+  out.clear();
+  iguana::to_json(t, out);
+  CHECK(out == R"({"id":1,"p":{"x": 2, "y": 3.5},"v":[1,2,3]})");
+  out.clear();
+  iguana::to_json_pretty<2>(t, out);
+  CHECK(out == "{\n  \"id\": 1,\n  \"p\": {\"x\": 2, \"y\": 3.5},\n  \"v\": "
+               "[\n    1,\n    2,\n    3\n  ]\n}");
+
+  lazy_t t1{.id = 2, .p = point_t{1, 0.5}, .v = {}};
+  out.clear();
+  iguana::to_json(t1, out);
+  CHECK(out == R"({"id":2,"p":{"x":1,"y":5E-1},"v":[]})");
+}
+
+TEST_CASE("test json pointer") {
+  std::string_view str = R"({"features": [ {"id": 1, "geometry" :
+      {"type" : "Point", "xy":[1, 2] } } ],
+      "a/b": {"m~n": true}, "esc\u0041": "x", "": 0})";
+
+  iguana::json_pointer type("/features/0/geometry/type");
+  CHECK(type.size() == 4);
+  CHECK(type.resolve(str) == R"("Point")");
+  CHECK(iguana::json_pointer("/features/0/geometry").resolve(str) ==
+        R"({"type" : "Point", "xy":[1, 2] })");
+  CHECK(iguana::json_pointer("/a~1b/m~0n").resolve(str) == "true");
+  CHECK(iguana::json_pointer("/escA").resolve(str) == R"("x")");
+  CHECK(iguana::json_pointer("/").resolve(str) == "0");
+  CHECK(iguana::json_pointer("/features/0/geometry/xy/1").resolve(str) == "2");
+  CHECK(iguana::json_pointer("/features/1").resolve(str) == std::nullopt);
+  CHECK(iguana::json_pointer("/features/01").resolve(str) == std::nullopt);
+  CHECK(iguana::json_pointer("/features/-").resolve(str) == std::nullopt);
+  CHECK(iguana::json_pointer("/nope").resolve(str) == std::nullopt);
+  CHECK(iguana::json_pointer("").resolve(str)->size() == str.size());
+  CHECK_THROWS(iguana::json_pointer("features"));
+  CHECK_THROWS(iguana::json_pointer("/a~2"));
+  CHECK_THROWS(iguana::json_pointer("/a").resolve(std::string_view("{\"")));
+  CHECK_THROWS(iguana::json_pointer("/a").resolve(std::string_view("{\"a")));
+
+  iguana::jvalue val;
+  iguana::parse(val, str);
+  CHECK(type.resolve(val)->to_string() == "Point");
+  CHECK(iguana::json_pointer("/a~1b/m~0n").resolve(val)->to_bool());
+  CHECK(iguana::json_pointer("/features/0/geometry/xy/2").resolve(val) ==
+        nullptr);
+  iguana::json_pointer("/a~1b/m~0n").resolve(val)->emplace<bool>(false);
+  CHECK(!iguana::json_pointer("/a~1b/m~0n").resolve(std::as_const(val))
+             ->to_bool());
+
+  iguana::jdocument doc;
+  iguana::parse(doc, str);
+  CHECK(type.resolve(doc.root())->to_string() == "Point");
+}
+
 TEST_CASE("test dom parse") {
   {
     std::string_view str = R"(null)";
@@ -194,6 +484,13 @@ TEST_CASE("test dom parse") {
     CHECK(!ec);
     CHECK(!b);
   }
+  {
+    std::string_view str = "{\"a\" :1,\"b\"\n\t: {\"c\"  :[]}}";
+    iguana::jvalue val;
+    iguana::parse(val, str.begin(), str.end());
+    CHECK(val.at<int>("a") == 1);
+    CHECK(val.find("b", "c")->is_array());
+  }
   {
     std::string_view str = R"({"name": "tom", "ok":true, "t": {"val":2.5}})";
     iguana::jvalue val;
@@ -398,6 +695,10 @@ TEST_CASE("test simple nested object") {
   CHECK(t.id == p.id);
   CHECK(t.p.name == p.p.name);
   CHECK(t.p.ok == p.p.ok);
+
+  iguana::string_stream expected;
+  iguana::to_json(t, expected);
+  CHECK(expected == R"({"id":1,"p":{"name":"tom","ok":false}})");
 }
 
 TEST_CASE("test c array and std::array") {
@@ -571,6 +872,93 @@ TEST_CASE("test complicated object") {
   CHECK(obj.string == "Hello world");
 }
 
+TEST_CASE("test stream sink") {
+  json0_obj_t obj;
+  iguana::from_json(obj, std::begin(json0), std::end(json0));
+  iguana::string_stream expected;
+  iguana::to_json(obj, expected);
+
+  std::string out;
+  size_t flushes = 0;
+  {
+    auto sink = iguana::make_sink<16>([&](const char *data, size_t size) {
+      // every chunk continues the output where the previous one stopped
+      CHECK(std::string_view(expected).substr(out.size(), size) ==
+            std::string_view(data, size));
+      out.append(data, size);
+      ++flushes;
+    });
+    iguana::to_json(obj, sink);
+    CHECK(sink.bytes_written() == expected.size());
+    CHECK(expected.size() - out.size() < 16);
+  }
+  CHECK(out == expected);
+  CHECK(flushes > 1);
+
+  std::ostringstream os;
+  {
+    auto sink = iguana::make_ostream_sink(os);
+    iguana::to_json(obj, sink);
+    sink.flush();
+    CHECK(os.str() == expected);
+  }
+}
+
+TEST_CASE("test to_json_pretty") {
+  json0_obj_t obj;
+  iguana::from_json(obj, std::begin(json0), std::end(json0));
+  iguana::string_stream compact;
+  iguana::to_json(obj, compact);
+
+  iguana::string_stream pretty;
+  iguana::to_json_pretty(obj, pretty);
+  CHECK(pretty == iguana::prettify(compact));
+
+  json0_obj_t obj1;
+  iguana::from_json(obj1, pretty);
+  CHECK(obj1.string == obj.string);
+  CHECK(obj1.another_object.nested_object.v3s ==
+        obj.another_object.nested_object.v3s);
+
+  std::string str;
+  iguana::to_json_pretty<2>(std::map<std::string, std::vector<int>>{
+                                {"a", {1, 2}}, {"b", {}}},
+                            str);
+  CHECK(str == "{\n  \"a\": [\n    1,\n    2\n  ],\n  \"b\": []\n}");
+
+  str.clear();
+  test_empty_t empty_obj;
+  iguana::to_json_pretty(empty_obj, str);
+  CHECK(str == "{}");
+}
+
+TEST_CASE("test minify and prettify") {
+  std::string_view str = R"( { "a b" : [ 1 , 2.5 , "x \" , y" ] ,
+    /* block */ "c":{"d" : null, "e":"\\"} // line
+  } )";
+  auto min = iguana::minify(str);
+  CHECK(min == R"({"a b":[1,2.5,"x \" , y"],"c":{"d":null,"e":"\\"}})");
+
+  auto pretty = iguana::prettify(min);
+  CHECK(pretty == R"({
+   "a b": [
+      1,
+      2.5,
+      "x \" , y"
+   ],
+   "c": {
+      "d": null,
+      "e": "\\"
+   }
+})");
+  CHECK(iguana::minify(pretty) == min);
+  CHECK(iguana::minify(iguana::prettify(json0)) == iguana::minify(json0));
+  CHECK(iguana::prettify(min, true).find("\n\t\t1,") != std::string::npos);
+
+  auto commented = iguana::prettify(std::string_view("[1, // c\n 2]"));
+  CHECK(commented == "[\n   1,\n    // c\n   2\n]");
+}
+
 TEST_CASE("test empty object") {
   test_empty_t empty_obj;
 
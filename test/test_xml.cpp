@@ -1,6 +1,8 @@
 #include <deque>
 #include <iterator>
 #include <list>
+#include <map>
+#include <memory_resource>
 #include <vector>
 #define DOCTEST_CONFIG_IMPLEMENT
 #include "doctest.h"
@@ -9,6 +11,7 @@
 #include "rapidxml_print.hpp"
 #include <iostream>
 #include <optional>
+#include <sstream>
 
 struct simple_t {
   std::vector<int> a;
@@ -80,6 +83,20 @@ TEST_CASE("test simple nested") {
   iguana::to_xml(nest2, ss);
 }
 
+TEST_CASE("test xml stream sink") {
+  nested_t nest{{{1, 2, 3}, '|', 0, 1, "e"}, 10086};
+  std::string expected;
+  iguana::to_xml(nest, expected);
+
+  std::string out;
+  {
+    auto sink = iguana::make_sink<8>(
+        [&](const char *data, size_t size) { out.append(data, size); });
+    iguana::to_xml(nest, sink);
+  }
+  CHECK(out == expected);
+}
+
 struct book_t {
   std::string title;
   int edition;
@@ -373,7 +390,8 @@ TEST_CASE("test exception") {
   CHECK_NOTHROW(iguana::from_xml(simple, str2.data())); // Failed to parse bool
   simple_t simple2{{1, 2, 3}, '|', 0, 1};
   std::string ss = "<<dd>>";
-  CHECK_FALSE(iguana::to_xml_pretty(simple2, ss)); // unexpected end of data
+  CHECK(iguana::to_xml_pretty(simple2, ss)); // appended, never re-parsed
+  CHECK(ss.starts_with("<<dd>><simple_t>\n"));
 
   std::string str3 = R"(
     <nested_t>
@@ -416,6 +434,11 @@ TEST_CASE("test xml namespace") {
 
   std::string ss;
   iguana::to_xml(it, ss);
+  CHECK(ss == "<item_t><item:itunes><itunes:author>Jupiter "
+              "Broadcasting</itunes:author><itunes:subtitle>Linux enthusiasts "
+              "talk top news stories, "
+              "subtitle</itunes:subtitle><itunes:user>10086</itunes:user></"
+              "item:itunes></item_t>");
   item_t it2;
   iguana::from_xml(it2, ss.data());
   auto itunes2 = it2.item_itunes.get();
@@ -485,8 +508,8 @@ TEST_CASE("parse error") {
 
   simple_t simple2{{1, 2, 3}, '|', 0, 1};
   std::string ss = "<<dd>>";
-  CHECK_FALSE(iguana::to_xml_pretty(simple2, ss)); // unexpected end of data
-  CHECK(!iguana::get_last_write_err().empty());
+  CHECK(iguana::to_xml_pretty(simple2, ss)); // appended, never re-parsed
+  CHECK(ss.starts_with("<<dd>><simple_t>\n"));
 }
 
 TEST_CASE("field not found") {
@@ -583,6 +606,359 @@ TEST_CASE("test cdata node") {
   CHECK(dscrp.cdata.get().empty());
 }
 
+struct entity_t {
+  std::string title;
+  std::vector<int> id;
+  std::optional<std::string> note;
+  std::map<std::string, std::string> __attr;
+};
+REFLECTION(entity_t, title, id, note, __attr);
+TEST_CASE("test xml without dom") {
+  std::string str = R"(<?xml version="1.0"?>
+    <!DOCTYPE entity_t>
+    <entity_t lang="a&amp;b" empty=''>
+      <id>1</id>
+      <!-- <title>not me</title> -->
+      <unknown><title>nested</title><x/></unknown>
+      <title>&lt;tom &amp; jerry&gt; &#65;&#x42;&#x4e2d; &bogus;</title>
+      <id>2</id>
+      <skipped/>
+      <note/>
+      <id>3</id>
+      <title>second</title>
+    </entity_t>
+  )";
+  entity_t e;
+  CHECK(iguana::from_xml(e, str.data()));
+  CHECK(e.title == "<tom & jerry> AB\xe4\xb8\xad &bogus;");
+  CHECK(e.id == std::vector{1, 2, 3});
+  CHECK(!e.note);
+  CHECK(e.__attr["lang"] == "a&b");
+  CHECK(e.__attr["empty"].empty());
+
+  std::string raw = "<entity_t><title>a &amp; b</title></entity_t>";
+  entity_t e4;
+  CHECK(iguana::from_xml<rapidxml::parse_fastest>(e4, raw.data()));
+  CHECK(e4.title == "a &amp; b");
+
+  std::string spaced = "<entity_t lang=' a  b '><title>\n  tom \t&amp;\n "
+                       " jerry &#32; </title><id> 4 </id></entity_t>";
+  entity_t e5;
+  CHECK(iguana::from_xml<rapidxml::parse_trim_whitespace |
+                         rapidxml::parse_normalize_whitespace>(
+      e5, spaced.data()));
+  CHECK(e5.title == "tom & jerry");
+  CHECK(e5.id == std::vector{4});
+  CHECK(e5.__attr["lang"] == " a  b ");
+
+  std::string untrimmed = "<entity_t><title> a\n\tb </title></entity_t>";
+  entity_t e6;
+  CHECK(iguana::from_xml<rapidxml::parse_normalize_whitespace>(
+      e6, untrimmed.data()));
+  CHECK(e6.title == " a b ");
+  untrimmed = "<entity_t><title> a\n\tb </title></entity_t>";
+  CHECK(iguana::from_xml<rapidxml::parse_trim_whitespace>(e6,
+                                                          untrimmed.data()));
+  CHECK(e6.title == "a\n\tb");
+
+  std::string mismatched =
+      "<entity_t><unknown><x></y></unknown><title>t</title></entity_t>";
+  entity_t e7;
+  CHECK(iguana::from_xml(e7, mismatched.data()));
+  mismatched =
+      "<entity_t><unknown><x></y></unknown><title>t</title></entity_t>";
+  iguana::xml_error err;
+  CHECK(!iguana::from_xml<rapidxml::parse_validate_closing_tags>(
+      e7, mismatched.data(), err));
+  CHECK(err.code == iguana::xml_errc::mismatched_tag);
+  CHECK(err.offset == mismatched.find("y>"));
+  std::string matched = "<entity_t><title>t</title ><id>1</id></entity_t>";
+  CHECK(iguana::from_xml<rapidxml::parse_validate_closing_tags>(
+      e7, matched.data()));
+  CHECK(e7.title == "t");
+
+  std::string self_closing = "<entity_t lang='x'/>";
+  entity_t e2;
+  CHECK(iguana::from_xml(e2, self_closing.data()));
+  CHECK(e2.__attr["lang"] == "x");
+  CHECK(e2.id.empty());
+
+  std::string truncated = "<entity_t><title>tom</title><id>1</id>";
+  entity_t e3;
+  CHECK(!iguana::from_xml(e3, truncated.data()));
+}
+
+TEST_CASE("test interleaved siblings") {
+  std::string str = R"(
+    <library_t>
+      <book><title>a</title><edition>1</edition><author>x</author></book>
+      <sum>2</sum>
+      <extra><book><title>ignored</title></book></extra>
+      <book><title>b</title><edition>2</edition><author>y</author></book>
+    </library_t>
+  )";
+  std::string copy = str;
+  library_t lib;
+  CHECK(iguana::from_xml(lib, str.data()));
+  CHECK(lib.sum == 2);
+  REQUIRE(lib.book.size() == 2);
+  CHECK(lib.book[1].title == "b");
+
+  rapidxml::xml_document<> doc;
+  doc.parse<0>(copy.data());
+  library_t dom_lib;
+  iguana::do_read(doc.first_node(), dom_lib);
+  CHECK(dom_lib.sum == 2);
+  REQUIRE(dom_lib.book.size() == 2);
+  CHECK(dom_lib.book[0].title == "a");
+  CHECK(dom_lib.book[1].author == std::vector<std::string>{"y"});
+  CHECK(dom_lib.book[1].edition == 2);
+}
+
+TEST_CASE("test xml streaming") {
+  std::string str = R"(<?xml version="1.0"?>
+    <library_t>
+      <sum>3</sum>
+      <!-- <book><title>commented</title></book> -->
+      <book><title>a &amp; b</title><edition>1</edition><author>x</author><author>y</author></book>
+      <shelf>
+        <book><title>c</title><edition>2</edition><author>z</author></book>
+      </shelf>
+      <book><title>d</title><edition>3</edition><author>w</author></book>
+    </library_t>
+  )";
+  std::istringstream in(str);
+  std::vector<book_t> books;
+  CHECK(iguana::from_xml_each<book_t>(
+      in, "book", [&](book_t &b) { books.push_back(b); }, 16));
+  REQUIRE(books.size() == 3);
+  CHECK(books[0].title == "a & b");
+  CHECK(books[0].author.size() == 2);
+  CHECK(books[1].title == "c");
+  CHECK(books[1].author == std::vector<std::string>{"z"});
+  CHECK(books[2].edition == 3);
+
+  std::istringstream truncated(str.substr(0, str.find("<title>d")));
+  size_t count = 0;
+  CHECK(!iguana::from_xml_each<book_t>(
+      truncated, "book", [&](book_t &) { ++count; }, 8));
+  CHECK(count == 2);
+
+  // a large element is searched once across many refills
+  std::string big = "<library_t><book><title>big</title>";
+  for (int i = 0; i < 1000; ++i) {
+    big += "<author>a" + std::to_string(i) + "</author><!-- c -->";
+  }
+  big += "</book></library_t>";
+  std::istringstream big_in(big);
+  books.clear();
+  CHECK(iguana::from_xml_each<book_t>(
+      big_in, "book", [&](book_t &b) { books.push_back(b); }, 16));
+  REQUIRE(books.size() == 1);
+  CHECK(books[0].author.size() == 1000);
+  CHECK(books[0].author[999] == "a999");
+
+  // malformed markup fails without reading the rest of the stream
+  std::istringstream bad_in("<library_t>< book/>" + std::string(4096, ' ') +
+                            "</library_t>");
+  CHECK(!iguana::from_xml_each<book_t>(
+      bad_in, "book", [](book_t &) {}, 16));
+  CHECK(iguana::get_last_read_err() == "expected element name at offset 12");
+  CHECK(bad_in.tellg() == 16);
+}
+
+struct view_t {
+  std::string_view title;
+  std::string_view author;
+  std::map<std::string_view, std::string_view> __attr;
+};
+REFLECTION(view_t, title, author, __attr);
+TEST_CASE("test xml const buffer") {
+  const std::string str =
+      R"(<view_t id="a&amp;b" lang="en"><title>tom &amp; jerry</title><author>hanna</author></view_t>)";
+  const std::string origin = str;
+  std::pmr::monotonic_buffer_resource arena;
+  view_t v;
+  CHECK(iguana::from_xml(v, std::string_view(str), &arena));
+  CHECK(str == origin);
+  CHECK(v.title == "tom & jerry");
+  CHECK(v.author == "hanna");
+  CHECK(v.author.data() >= str.data());
+  CHECK(v.author.data() < str.data() + str.size());
+  CHECK(v.__attr["id"] == "a&b");
+  CHECK(v.__attr["lang"].data() >= str.data());
+
+  view_t v2;
+  CHECK(!iguana::from_xml(v2, std::string_view(str)));
+  CHECK(!iguana::get_last_read_err().empty());
+
+  view_t v3;
+  CHECK(iguana::from_xml(
+      v3, std::string_view("<view_t><author>hanna</author></view_t>")));
+  CHECK(v3.author == "hanna");
+}
+
+TEST_CASE("test xml escape") {
+  entity_t e;
+  e.title = "<tom & \"jerry\"> 'cartoon' with a long clean tail";
+  e.id = {1};
+  e.__attr["lang"] = "a&b<\"c\">'d'";
+  std::string ss;
+  iguana::to_xml(e, ss);
+  CHECK(ss.find("<title>&lt;tom &amp; \"jerry\"&gt; 'cartoon' with a long "
+                "clean tail</title>") != std::string::npos);
+  CHECK(ss.find(R"(lang="a&amp;b&lt;&quot;c&quot;&gt;&apos;d&apos;")") !=
+        std::string::npos);
+
+  entity_t e2;
+  CHECK(iguana::from_xml(e2, ss.data()));
+  CHECK(e2.title == e.title);
+  CHECK(e2.__attr["lang"] == e.__attr["lang"]);
+}
+
+TEST_CASE("test xml pretty") {
+  nested_t nest{{{1, 2}, '|', 0, 1, "e"}, 10086};
+  std::string ss;
+  CHECK(iguana::to_xml_pretty(nest, ss));
+  CHECK(ss == "<nested_t>\n"
+              "\t<simple>\n"
+              "\t\t<a>1</a>\n"
+              "\t\t<a>2</a>\n"
+              "\t\t<b>|</b>\n"
+              "\t\t<c>false</c>\n"
+              "\t\t<d>true</d>\n"
+              "\t\t<e>e</e>\n"
+              "\t</simple>\n"
+              "\t<code>10086</code>\n"
+              "</nested_t>\n");
+  nested_t nest2;
+  CHECK(iguana::from_xml(nest2, ss.data()));
+  CHECK(nest2.simple == nest.simple);
+  CHECK(nest2.code == 10086);
+}
+
+TEST_CASE("test xml error result") {
+  std::string str = "<book_t><title>t</title><edition>x2</edition></book_t>";
+  book_t book;
+  iguana::xml_error err;
+  CHECK(!iguana::from_xml(book, str.data(), err));
+  CHECK(err.code == iguana::xml_errc::invalid_number);
+  CHECK(err.element == "edition");
+  CHECK(err.offset == str.find("x2"));
+  CHECK(err.error_code() == iguana::xml_errc::invalid_number);
+  CHECK(err.path_size == 2);
+  CHECK(err.path[0] == "book_t");
+  CHECK(err.path[1] == "edition");
+
+  std::string nested = "<library><book><title>t</title></book><book>"
+                       "<edition>x</edition></book></library>";
+  library_t lib;
+  CHECK(!iguana::from_xml(lib, nested.data(), err));
+  CHECK(err.element == "edition");
+  CHECK(err.path_size == 3);
+  CHECK(err.path[0] == "library");
+  CHECK(err.path[1] == "book");
+  CHECK(err.path[2] == "edition");
+  CHECK(err.offset == nested.find(">x<") + 1);
+
+  std::string required = "<book_with_required><title>t</title>"
+                         "</book_with_required>";
+  book_with_required book2;
+  CHECK(!iguana::from_xml(book2, required.data(), err));
+  CHECK(err.code == iguana::xml_errc::missing_required);
+  CHECK(err.element == "edition");
+  CHECK(err.path_size == 2);
+  CHECK(err.path[0] == "book_with_required");
+  CHECK(err.offset == required.find("</book_with_required>"));
+  CHECK(iguana::get_last_read_err().empty());
+
+  std::vector<std::string> missing;
+  auto prev = iguana::set_xml_diagnostics([&](const iguana::xml_error &e) {
+    CHECK(e.code == iguana::xml_errc::missing_element);
+    missing.emplace_back(e.element);
+  });
+  std::string partial = "<book_t><title>t</title><edition>2</edition></book_t>";
+  CHECK(iguana::from_xml(book, partial.data(), err));
+  CHECK(!err);
+  CHECK(missing == std::vector<std::string>{"author"});
+  iguana::set_xml_diagnostics(std::move(prev));
+
+  std::string truncated = "<book_t><title>t</title";
+  CHECK(!iguana::from_xml(book, truncated.data()));
+  CHECK(iguana::get_last_read_err() ==
+        "expected > in <book_t/title> at offset 16");
+}
+
+struct enclosure_t {
+  std::pair<std::string_view, iguana::xml_attrs> media;
+  iguana::xml_attrs __attr;
+};
+REFLECTION(enclosure_t, media, __attr);
+TEST_CASE("test xml_attrs") {
+  std::string str = R"(<enclosure url="http://a/b.mp3" length="10" type="audio/mpeg">
+    <media a="1" b="2" c="3" d="4" e="5" f="6" g="7" h="8" i="9" j="&amp;">m</media>
+  </enclosure>)";
+  enclosure_t e;
+  CHECK(iguana::from_xml(e, str.data()));
+  CHECK(e.__attr.size() == 3);
+  CHECK(e.__attr["url"] == "http://a/b.mp3");
+  CHECK(e.__attr.begin()->first == "url");
+  CHECK(e.__attr["missing"].empty());
+  CHECK(e.media.first == "m");
+  CHECK(e.media.second.size() == 10);
+  CHECK(e.media.second["a"] == "1");
+  CHECK(e.media.second["j"] == "&");
+
+  std::string ss;
+  iguana::to_xml(e, ss);
+  CHECK(ss.starts_with(
+      R"(<enclosure_t url="http://a/b.mp3" length="10" type="audio/mpeg">)"));
+  CHECK(ss.find(R"(i="9" j="&amp;">m</media>)") != std::string::npos);
+
+  e.media.second.clear();
+  CHECK(e.media.second.empty());
+  e.media.second.emplace("k", "v");
+  CHECK(e.media.second.at("k") == "v");
+}
+
+TEST_CASE("test xml parallel") {
+  std::string str = "<library>";
+  for (int i = 0; i < 200; ++i) {
+    auto n = std::to_string(i);
+    str += "<book><title>t" + n + " &amp; co</title><edition>" + n +
+           "</edition><author>a" + n + "</author></book>";
+    if (i == 100) {
+      str += "<sum>200</sum>";
+    }
+  }
+  str += "</library>";
+
+  library_t expected;
+  auto copy = str;
+  CHECK(iguana::from_xml(expected, copy.data()));
+  REQUIRE(expected.book.size() == 200);
+
+  library_t lib;
+  copy = str;
+  CHECK(iguana::from_xml_parallel(lib, copy.data(), 4));
+  CHECK(lib.sum == 200);
+  CHECK(lib.book == expected.book);
+  CHECK(lib.book[199].title == "t199 & co");
+
+  auto bad = str;
+  auto pos = bad.find("<edition>150<") + 9;
+  bad[pos] = 'x';
+  iguana::xml_error err;
+  library_t broken;
+  CHECK(!iguana::from_xml_parallel(broken, bad.data(), err, 4));
+  CHECK(err.element == "edition");
+  CHECK(err.path_size == 3);
+  CHECK(err.path[0] == "library");
+  CHECK(err.path[1] == "book");
+  CHECK(err.code == iguana::xml_errc::invalid_number);
+  CHECK(err.offset == pos);
+}
+
 // doctest comments
 // 'function' : must be 'attribute' - see issue #182
 DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4007)
@@ -2,6 +2,8 @@
 #include <deque>
 #include <iterator>
 #include <list>
+#include <map>
+#include <memory_resource>
 #include <vector>
 #define DOCTEST_CONFIG_IMPLEMENT
 #include "doctest.h"
@@ -476,6 +478,79 @@ TEST_CASE("test long") {
   CHECK(app1.id == 1234);
 }
 
+TEST_CASE("test integer formatting") {
+  auto to_str = [](auto v) {
+    std::string str;
+    iguana::to_json(std::vector{v}, str);
+    return str;
+  };
+  CHECK(to_str(int8_t(-128)) == "[-128]");
+  CHECK(to_str(uint8_t(255)) == "[255]");
+  CHECK(to_str(int16_t(-32768)) == "[-32768]");
+  CHECK(to_str(uint16_t(0)) == "[0]");
+  CHECK(to_str(int32_t(-2147483647 - 1)) == "[-2147483648]");
+  CHECK(to_str(uint32_t(4294967295u)) == "[4294967295]");
+  CHECK(to_str(int64_t(-9223372036854775807ll - 1)) ==
+        "[-9223372036854775808]");
+  CHECK(to_str(uint64_t(18446744073709551615ull)) ==
+        "[18446744073709551615]");
+
+  uint64_t v = 1;
+  for (int i = 0; i < 20; ++i, v *= 10) {
+    CHECK(to_str(v) == "[" + std::to_string(v) + "]");
+    CHECK(to_str(v - 1) == "[" + std::to_string(v - 1) + "]");
+  }
+}
+
+struct fixed_point_t {
+  iguana::fixed_t<double, 6> lat;
+  iguana::fixed_t<double, 2> price;
+  iguana::fixed_t<float, 0> count;
+};
+REFLECTION(fixed_point_t, lat, price, count);
+
+TEST_CASE("test fixed precision and bulk doubles") {
+  fixed_point_t pt{{51.5}, {-0.005}, {41.6f}};
+  std::string str;
+  iguana::to_json(pt, str);
+  CHECK(str == R"({"lat":51.500000,"price":-0.01,"count":42})");
+
+  fixed_point_t pt1;
+  iguana::from_json(pt1, str);
+  CHECK(pt1.lat.value == 51.5);
+  CHECK(pt1.price.value == -0.01);
+
+  std::vector<iguana::fixed_t<double, 3>> v{{0.0004}, {-0.0004}, {1e300}};
+  str.clear();
+  iguana::to_json(v, str);
+  CHECK(str == "[0.000,0.000,1E300]");
+
+  std::vector<double> dv{1.5, -0.25, 1e-7, 0};
+  str.clear();
+  iguana::to_json(dv, str);
+  CHECK(str == "[1.5E0,-2.5E-1,1E-7,0E0]");
+
+  std::vector<double> dv1;
+  iguana::from_json(dv1, str);
+  CHECK(dv1 == dv);
+
+  std::array<float, 2> fa{0.5f, 2.f};
+  str.clear();
+  iguana::render_json_value(str, fa);
+  CHECK(str == "[5E-1,2E0]");
+
+  // longer than one chunk of the stack buffer
+  std::vector<double> many(100, -1.5);
+  std::string expected = "[-1.5E0";
+  for (size_t i = 1; i < many.size(); ++i) {
+    expected += ",-1.5E0";
+  }
+  expected += "]";
+  str = "x";
+  iguana::to_json(many, str);
+  CHECK(str == "x" + expected);
+}
+
 TEST_CASE("test unknown fields") {
   std::string str = R"({"dummy":0, "name":"tom", "age":20})";
   person p;
@@ -527,18 +602,71 @@ TEST_CASE("test escape in string") {
   iguana::from_json(p, str);
   CHECK(p.name == "A\nB\tC\rD\bEF\n\f\n");
   CHECK(p.age == 20);
+
+  std::string out;
+  iguana::to_json(p, out);
+  CHECK(out == R"({"name":"A\nB\tC\rD\bEF\n\f\n","age":20})");
+
+  person p1{.name = std::string("\"q\"\\ \x01", 6), .age = 1};
+  out.clear();
+  iguana::to_json(p1, out);
+  CHECK(out == R"({"name":"\"q\"\\ \u0001","age":1})");
+  person p2;
+  iguana::from_json(p2, out);
+  CHECK(p2.name == p1.name);
 }
 
+struct pmr_person {
+  std::pmr::string name;
+  std::pmr::vector<std::pmr::string> tags;
+  std::pmr::map<std::pmr::string, int> scores;
+};
+REFLECTION(pmr_person, name, tags, scores);
+
 TEST_CASE("test pmr") {
-#ifdef IGUANA_ENABLE_PMR
-#if __has_include(<memory_resource>)
-  iguana::string_stream str{&iguana::iguana_resource};
-#endif
-#else
-  iguana::string_stream str;
-#endif
+  char buf[4096];
+  std::pmr::monotonic_buffer_resource resource(buf, sizeof(buf));
+
   person obj{.name = "tom", .age = 20};
-  iguana::to_json(obj, str);
+  auto str = iguana::to_json(obj, &resource);
+  CHECK(str == R"({"name":"tom","age":20})");
+  CHECK(str.get_allocator().resource() == &resource);
+
+  std::string json =
+      R"({"name":"a name longer than the small string buffer",
+          "tags":["first tag that does not fit inline", "b"],
+          "scores":{"a long key that needs an allocation":1}})";
+  pmr_person p;
+  iguana::from_json(p, json, &resource);
+  CHECK(p.name == "a name longer than the small string buffer");
+  CHECK(p.name.get_allocator().resource() == &resource);
+  CHECK(p.tags.get_allocator().resource() == &resource);
+  CHECK(p.tags[0].get_allocator().resource() == &resource);
+  CHECK(p.tags[1] == "b");
+  CHECK(p.scores.get_allocator().resource() == &resource);
+  CHECK(p.scores.begin()->first.get_allocator().resource() == &resource);
+
+  std::pmr::string written(&resource);
+  iguana::to_json(p, written);
+  CHECK(written ==
+        R"({"name":"a name longer than the small string buffer",)"
+        R"("tags":["first tag that does not fit inline","b"],)"
+        R"("scores":{"a long key that needs an allocation":1}})");
+  pmr_person round_trip;
+  iguana::from_json(round_trip, written, &resource);
+  CHECK(round_trip.name == p.name);
+  CHECK(round_trip.tags == p.tags);
+  CHECK(round_trip.scores == p.scores);
+
+  // no resource leaves the members alone
+  pmr_person p1;
+  iguana::from_json(p1, json);
+  CHECK(p1.name.get_allocator().resource() ==
+        std::pmr::get_default_resource());
+
+  iguana::jdocument doc;
+  iguana::parse(doc, json, &resource);
+  CHECK(doc.root().find("tags", 1)->to_string() == "b");
 }
 
 TEST_CASE("test from_json_file") {